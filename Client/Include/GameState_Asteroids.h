@@ -77,20 +77,26 @@ enum TYPE
 };
 
 
-enum MESSAGE_TYPE
+enum INPUT_KEY
 {
-	// list of possible message types
-	TYPE_MOVEMENT_UP,
-	TYPE_MOVEMENT_DOWN,
-	TYPE_MOVEMENT_LEFT,
-	TYPE_MOVEMENT_RIGHT,
-	TYPE_SHOOT
+	// bits of the keys held in one input tick, same as the server
+	INPUT_KEY_UP		= 1 << 0,
+	INPUT_KEY_DOWN	= 1 << 1,
+	INPUT_KEY_LEFT	= 1 << 2,
+	INPUT_KEY_RIGHT	= 1 << 3,
+	INPUT_KEY_SHOOT	= 1 << 4
 };
 
+int constexpr INPUT_REDUNDANCY{ 4 };		// ticks of keys every input datagram carries
+
+// written as an input packet, see Protocol.h
 struct CLIENT_MESSAGE_FORMAT
 {
+	int RoomID;
 	int ShipID;
-	int MessageType;
+	int Tick;													// input tick of Keys[0]
+	unsigned int Ack;									// newest snapshot received, SNAPSHOT_NONE for none
+	unsigned char Keys[INPUT_REDUNDANCY];			// INPUT_KEY bits held in Tick, Tick - 1, ...
 };
 
 struct SERVER_MESSAGE_FORMAT
@@ -151,7 +157,7 @@ void GameStateAsteroidsDraw(void);
 void GameStateAsteroidsFree(void);
 void GameStateAsteroidsUnload(void);
 
-void SendEventToServer(int shipID, MESSAGE_TYPE messageType);
+void SendEventToServer(int shipID, int tick, const unsigned char* keys);
 void gameObjInstSet(int id, unsigned long type, float scale, AEVec2* pPos, AEVec2* pVel, float dir);
 void SetDeadReckInfo(int id, bool i, AEVec2 v, float rot);
 AEVec2 GetObjPos(int id);
@@ -160,6 +166,7 @@ int GetShipLive(int id);
 void RespawnShip(int id, unsigned long type, float scale, AEVec2* pPos, AEVec2* pVel, float dir);
 void SetPackageInterval();
 void resetNonGameObjs(int offset);
+void gameObjInstRemove(int id);
 
 extern GameObjInst sGameObjInstList[GAME_OBJ_INST_NUM_MAX];
 
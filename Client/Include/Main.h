@@ -29,6 +29,7 @@ prior written consent of DigiPen Institute of Technology is prohibited.
 
 #include "GameStateMgr.h"
 #include "GameState_Asteroids.h"
+#include "Protocol.h"
 
 #include "ws2tcpip.h"
 #pragma comment(lib, "ws2_32.lib")
@@ -38,10 +39,23 @@ prior written consent of DigiPen Institute of Technology is prohibited.
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <atomic>
 
+// the ship id of a join reply is the server's entity handle, the slot the
+// snapshots name a ship by is in its low bits
+const unsigned int	ENTITY_INDEX_BITS = 20;			// same as the server's EntityStore.h
+
+inline int EntityIndex(int handle)
+{
+	return handle & ((1 << ENTITY_INDEX_BITS) - 1);
+}
+
+// read from a join reply, see Protocol.h
 struct SERVER_INITIAL_MESSAGE_FORMAT
 {
 	int ShipID;
+	int RoomID;
+	int TickRate;		// inputs are sent once per tick of this rate
 };
 
 struct GAME_SCORE {
@@ -61,6 +75,10 @@ extern std::string serverPort;
 extern addrinfo* serverInfo;
 extern SOCKET clientSocket;
 extern int assignedShipID;
+extern int assignedRoomID;
+extern int assignedTickRate;
+extern QuantizeConfig snapshotQuantize;		// how the server packs snapshots, from the join reply
+extern std::atomic<u32> snapshotAcked;			// newest snapshot received, sent back with every input
 extern GAME_SCORE gameScore;
 extern std::mutex GAME_OBJECT_LIST_MUTEX;
 extern std::mutex GAME_SCORE_MUTEX;
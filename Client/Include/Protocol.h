@@ -0,0 +1,318 @@
+/******************************************************************************/
+/*!
+\file			Protocol.h
+\author
+\par
+\date
+\brief		This is the wire protocol header file, the same on the client and
+					the server. Every datagram starts with a header and every field
+					is written one byte at a time, little endian, so the layout does
+					not depend on the compiler or the machine that built either side.
+
+					Layouts after the header:
+						join				room u32 (ROOM_INVALID)
+						join reply	ship u32, room u32, tick rate u16, QuantizeConfig
+						input				room u32, ship u32, ack u32 (newest snapshot received),
+												INPUT_REDUNDANCY key u8, newest first
+						snapshot		fragment u8, fragment count u8, ship count u16,
+												baseline u32, then bits
+												ships		dead 1, lives 11, score 32, entity
+												objects	removed count 12, changed count 12,
+																removed slot 11 each, then changes
+											padded to a whole byte, at most PROTOCOL_FRAGMENT_SIZE
+
+					A snapshot goes out as fragments that each fit one unfragmented
+					datagram and decode on their own, the ships come in the first.
+
+					A snapshot entity is slot 11, type 2, has scale 1, has velocity 1,
+					x and y positionBits, direction angleBits, then scale f32 when it
+					is not the type's default and x and y velocityBits when it moves.
+
+					Objects are sent as changes to the baseline, a snapshot the client
+					acked, or all of them for SNAPSHOT_NONE. A change is slot 11 and
+					spawn 1, a spawn is followed by an entity without its slot, any
+					other change by position 1 [x y], direction 1 [direction],
+					velocity 1 [moving 1 [x y]] and scale 1 [f32]. Objects not named
+					keep their baseline, moved on by their velocity.
+
+					Client datagrams carry the room right after the header, the
+					server steers them to the room's shard by its low byte.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_PROTOCOL_H_
+#define ASS4_PROTOCOL_H_
+
+#include "AEEngine.h"
+#include <vector>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+const u16						PROTOCOL_MAGIC = 0xA5E7;
+const u8						PROTOCOL_VERSION = 4;						// bumped on every layout change
+
+const unsigned int	PROTOCOL_HEADER_SIZE = 12;
+const unsigned int	PROTOCOL_ROOM_OFFSET = PROTOCOL_HEADER_SIZE;
+const unsigned int	PROTOCOL_SLOT_BITS = 11;						// entity slots, below GAME_OBJ_INST_NUM_MAX
+const unsigned int	PROTOCOL_TYPE_BITS = 2;
+const unsigned int	PROTOCOL_TYPE_NUM = 1 << PROTOCOL_TYPE_BITS;
+const unsigned int	PROTOCOL_LIVES_BITS = 11;
+const unsigned int	PROTOCOL_COUNT_BITS = 12;						// objects removed or changed in one snapshot
+const unsigned int	PROTOCOL_SNAPSHOT_HISTORY = 32;			// snapshots kept to delta against, a power of 2
+const unsigned int	PROTOCOL_FRAGMENT_SIZE = 1200;				// largest snapshot datagram, below any path mtu
+const unsigned int	PROTOCOL_FRAGMENT_HEADER_SIZE = PROTOCOL_HEADER_SIZE + 8;
+const unsigned int	PROTOCOL_FRAGMENT_MAX = 64;					// fragments of one snapshot
+const unsigned int	PROTOCOL_PACKET_MAX = 65507;				// largest udp payload
+
+enum PACKET_TYPE
+{
+	PACKET_JOIN,
+	PACKET_JOIN_REPLY,
+	PACKET_INPUT,
+	PACKET_SNAPSHOT,
+
+	PACKET_TYPE_NUM
+};
+
+struct PacketHeader
+{
+	u16		magic;
+	u8		version;
+	u8		type;					// PACKET_TYPE
+	u32		tick;					// tick of the sender the packet is about
+	u32		sequence;			// counts the packets of one type from one sender
+};
+
+// writes into a buffer the caller owns, a write past the end is dropped and
+// marks the writer as overflowed
+struct PacketWriter
+{
+	u8*						data;
+	unsigned int	capacity;
+	unsigned int	size;
+	bool					overflow;
+};
+
+// reads a received datagram, a read past the end gives 0 and marks the
+// reader as overflowed, so a short packet is checked once at the end
+struct PacketReader
+{
+	const u8*			data;
+	unsigned int	size;
+	unsigned int	offset;
+	bool					overflow;
+};
+
+// packs values of any width into a packet, lowest bits first
+struct BitWriter
+{
+	PacketWriter*	out;
+	u64						scratch;
+	unsigned int	count;			// bits waiting in scratch
+};
+
+struct BitReader
+{
+	PacketReader*	in;
+	u64						scratch;
+	unsigned int	count;
+};
+
+// how snapshot entities are packed, chosen by the server and sent in the
+// join reply
+struct QuantizeConfig
+{
+	f32		minX, maxX, minY, maxY;						// positions are fixed point over these
+	f32		velocityMax;										// so is each velocity component, over +-velocityMax
+	u8		positionBits;
+	u8		angleBits;
+	u8		velocityBits;
+	f32		defaultScale[PROTOCOL_TYPE_NUM];	// a scale that is not this one is sent in full
+	u32		driftX, driftY;									// position steps one velocity step covers in a tick, 16.16
+};
+
+// what a snapshot says about one ship or object
+struct SnapshotEntity
+{
+	u32		slot;
+	u8		type;
+	f32		scale;
+	f32		posX, posY;
+	f32		velX, velY;
+	f32		dir;
+};
+
+// an entity as it goes on the wire, quantized. deltas compare these so the
+// two sides agree on every bit
+struct EntityState
+{
+	u32		slot;
+	u32		id;							// tells a reused slot apart, the server's handle
+	u8		type;
+	bool	moving;					// velX and velY mean something
+	u32		x, y, angle;
+	u32		velX, velY;
+	f32		scale;
+	s32		carryX, carryY;				// what prediction moved it past x and y, in 1/65536 steps
+};
+
+const u32						SNAPSHOT_NONE = 0xFFFFFFFF;		// no snapshot, the baseline of a full one
+
+// the objects of one snapshot sorted by slot, as the client has them
+struct SnapshotFrame
+{
+	u32												sequence;			// SNAPSHOT_NONE for an unused frame
+	u32												tick;
+	std::vector<EntityState>	objects;
+	unsigned int							fragments;		// the client's, how many the snapshot was sent in
+	u64												received;			// and a bit for each of them that arrived
+};
+
+// what changed of an object since the baseline
+enum SNAPSHOT_CHANGE
+{
+	SNAPSHOT_CHANGE_SPAWN			= 1 << 0,		// new, or another object in the same slot
+	SNAPSHOT_CHANGE_POSITION	= 1 << 1,
+	SNAPSHOT_CHANGE_ANGLE			= 1 << 2,
+	SNAPSHOT_CHANGE_VELOCITY	= 1 << 3,
+	SNAPSHOT_CHANGE_SCALE			= 1 << 4,
+};
+
+struct SnapshotChange
+{
+	unsigned int	object;			// in the sent frame
+	unsigned int	mask;				// SNAPSHOT_CHANGE bits
+};
+
+// the removed slots and changes of one fragment, ranges of the whole lists
+struct SnapshotFragment
+{
+	unsigned int	removedBegin, removedEnd;
+	unsigned int	changeBegin, changeEnd;
+};
+
+// the last snapshots sent to or received from one client
+struct SnapshotHistory
+{
+	SnapshotFrame		frames[PROTOCOL_SNAPSHOT_HISTORY];
+	u32							acked;						// newest sequence the client has, or SNAPSHOT_NONE
+};
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+void PacketWriterInit(PacketWriter& writer, void* data, unsigned int capacity);
+void PacketWriteU8(PacketWriter& writer, u8 value);
+void PacketWriteU16(PacketWriter& writer, u16 value);
+void PacketWriteU32(PacketWriter& writer, u32 value);
+void PacketWriteS16(PacketWriter& writer, s16 value);
+void PacketWriteS32(PacketWriter& writer, s32 value);
+void PacketWriteF32(PacketWriter& writer, f32 value);
+void PacketWriteHeader(PacketWriter& writer, PACKET_TYPE type, u32 tick, u32 sequence);
+
+void PacketReaderInit(PacketReader& reader, const void* data, unsigned int size);
+u8 PacketReadU8(PacketReader& reader);
+u16 PacketReadU16(PacketReader& reader);
+u32 PacketReadU32(PacketReader& reader);
+s16 PacketReadS16(PacketReader& reader);
+s32 PacketReadS32(PacketReader& reader);
+f32 PacketReadF32(PacketReader& reader);
+
+// false for a datagram of another program or another protocol version
+bool PacketReadHeader(PacketReader& reader, PacketHeader& header);
+
+void BitWriterInit(BitWriter& writer, PacketWriter& out);
+void BitWrite(BitWriter& writer, u32 value, unsigned int bits);		// bits up to 32
+void BitWriterFlush(BitWriter& writer);														// pads to a whole byte with 0s
+
+void BitReaderInit(BitReader& reader, PacketReader& in);
+u32 BitRead(BitReader& reader, unsigned int bits);
+void BitReaderAlign(BitReader& reader);														// skips the padding of a flush
+
+// value clamped to [min, max] as a bits wide fixed point number, and back
+u32 Quantize(f32 value, f32 min, f32 max, unsigned int bits);
+f32 Dequantize(u32 value, f32 min, f32 max, unsigned int bits);
+
+// largest difference between a value in [min, max] and what it comes back as
+f32 QuantizeError(f32 min, f32 max, unsigned int bits);
+
+void QuantizeWrite(PacketWriter& writer, const QuantizeConfig& config);
+void QuantizeRead(PacketReader& reader, QuantizeConfig& config);
+
+void EntityStateQuantize(const QuantizeConfig& config, const SnapshotEntity& entity, EntityState& state);
+void EntityStateDequantize(const QuantizeConfig& config, const EntityState& state, SnapshotEntity& entity);
+
+// moves a state on by its velocity, both sides do it the same to the bit
+void EntityStatePredict(const QuantizeConfig& config, EntityState& state, u32 ticks);
+
+void SnapshotWriteEntity(BitWriter& writer, const QuantizeConfig& config, const EntityState& state);
+void SnapshotReadEntity(BitReader& reader, const QuantizeConfig& config, EntityState& state);
+
+void SnapshotHistoryInit(SnapshotHistory& history);
+
+// frame of sequence to delta the snapshot numbered next against, nullptr
+// when it is gone or next would take its place
+SnapshotFrame* SnapshotHistoryBaseline(SnapshotHistory& history, u32 sequence, u32 next);
+
+// emptied frame for sequence, in place of the one PROTOCOL_SNAPSHOT_HISTORY before it
+SnapshotFrame& SnapshotHistoryAdd(SnapshotHistory& history, u32 sequence, u32 tick);
+
+// finds what changed from baseline or nullptr to current, sorted by slot,
+// and fills sent with what the client makes of it. an object within
+// tolerance position steps of its predicted place is left out
+void SnapshotDiff(const QuantizeConfig& config, const SnapshotFrame* baseline, const std::vector<EntityState>& current,
+	u32 tolerance, SnapshotFrame& sent, std::vector<u32>& removed, std::vector<SnapshotChange>& changes);
+
+// leaves the removals from keepRemoved on and the changes from keepChanges
+// on out of this snapshot, sent goes back to what the client still has for
+// them: the predicted baseline object, or nothing for a spawn in a slot the
+// baseline does not have
+void SnapshotDefer(const QuantizeConfig& config, const SnapshotFrame* baseline, SnapshotFrame& sent,
+	std::vector<u32>& removed, unsigned int keepRemoved, std::vector<SnapshotChange>& changes, unsigned int keepChanges);
+
+// bits a change takes in a fragment
+unsigned int SnapshotChangeBits(const QuantizeConfig& config, const EntityState& state, unsigned int mask);
+
+// datagram bytes of a snapshot cut like SnapshotPlanFragments cuts it, so
+// far: bytes of the fragments that are full and bits of the one filling up
+struct SnapshotPacking
+{
+	unsigned int	bytes;
+	unsigned int	used;
+};
+
+void SnapshotPackingInit(SnapshotPacking& packing, unsigned int firstBits);
+
+// puts bits more in and returns the bytes of every fragment so far
+unsigned int SnapshotPackingAdd(SnapshotPacking& packing, unsigned int bits);
+
+// cuts the removed slots, then the changes in their order, into fragments
+// of PROTOCOL_FRAGMENT_SIZE, the first one also holds firstBits of ships
+void SnapshotPlanFragments(const QuantizeConfig& config, const SnapshotFrame& sent, const std::vector<u32>& removed,
+	const std::vector<SnapshotChange>& changes, unsigned int firstBits, std::vector<SnapshotFragment>& fragments);
+
+void SnapshotWriteFragment(BitWriter& writer, const QuantizeConfig& config, const SnapshotFrame& sent,
+	const std::vector<u32>& removed, const std::vector<SnapshotChange>& changes, const SnapshotFragment& fragment);
+
+// every fragment of a frame the client started arrived
+bool SnapshotFrameComplete(const SnapshotFrame& frame);
+
+// starts frame as baseline or nullptr moved on to the frame's tick, the
+// fragments then change it as they arrive in any order
+void SnapshotFrameStart(const QuantizeConfig& config, const SnapshotFrame* baseline, SnapshotFrame& frame);
+
+// applies one fragment to its frame. false for a fragment that does not fit
+// the frame or is cut off, the frame is then of no use
+bool SnapshotReadFragment(BitReader& reader, const QuantizeConfig& config, SnapshotFrame& frame);
+
+// bits of one entity with and without its optional fields
+unsigned int SnapshotEntityBits(const QuantizeConfig& config, bool scale, bool velocity);
+
+#endif // ASS4_PROTOCOL_H_
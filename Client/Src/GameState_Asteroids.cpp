@@ -52,6 +52,10 @@ static unsigned long		sScore;										// Current score
 static bool onValueChange = true;
 static double packageInterval{};
 static double timeElapsed{};
+static double inputElapsed{};		// time not yet sent as input ticks
+static int inputTick{};					// number of the next input tick
+static bool shootPending{};			// space was pressed since the last input tick
+static unsigned char inputKeys[INPUT_REDUNDANCY]{};	// keys of the last input ticks, newest first
 DEAD_RECK_INFO			DeadReckList[GAME_OBJ_INST_NUM_MAX];	// Each element in this array represents a unique game object instance (sprite)
 static std::vector<SHIP_OBJ> allShipInfo{};  // vector storing the info of each ship (live, id, score)
 
@@ -301,29 +305,65 @@ void GameStateAsteroidsUpdate(void)
 	}
 
 	
-	if (AEInputCheckCurr(AEVK_UP))
+	// the server takes one input per tick, so the held keys go out once per
+	// tick of its rate, whatever the frame rate. a press between two ticks
+	// waits for the next one
+	if (AEInputCheckTriggered(AEVK_SPACE))
 	{
-		SendEventToServer(assignedShipID, MESSAGE_TYPE::TYPE_MOVEMENT_UP);
+		shootPending = true;
 	}
 
-	if (AEInputCheckCurr(AEVK_DOWN))
+	const double inputStep = 1.0 / static_cast<double>(assignedTickRate);
+	inputElapsed += AEFrameRateControllerGetFrameTime();
+	for (int ticks = 0; inputElapsed >= inputStep; ++ticks)
 	{
-		SendEventToServer(assignedShipID, MESSAGE_TYPE::TYPE_MOVEMENT_DOWN);
-	}
+		inputElapsed -= inputStep;
 
-	if (AEInputCheckCurr(AEVK_LEFT))
-	{
-		SendEventToServer(assignedShipID, MESSAGE_TYPE::TYPE_MOVEMENT_LEFT);
-	}
+		// after a long stall the old ticks are late anyway, skip them
+		if (ticks >= 8)
+		{
+			inputTick += static_cast<int>(inputElapsed / inputStep);
+			inputElapsed = 0.0;
+			break;
+		}
 
-	if (AEInputCheckCurr(AEVK_RIGHT))
-	{
-		SendEventToServer(assignedShipID, MESSAGE_TYPE::TYPE_MOVEMENT_RIGHT);
-	}
+		// one datagram per tick with every held key, even none, after the
+		// keys of the ticks before it
+		unsigned char keys{};
+		if (AEInputCheckCurr(AEVK_UP))
+		{
+			keys |= INPUT_KEY_UP;
+		}
 
-	if (AEInputCheckTriggered(AEVK_SPACE))
-	{
- 		SendEventToServer(assignedShipID, MESSAGE_TYPE::TYPE_SHOOT);
+		if (AEInputCheckCurr(AEVK_DOWN))
+		{
+			keys |= INPUT_KEY_DOWN;
+		}
+
+		if (AEInputCheckCurr(AEVK_LEFT))
+		{
+			keys |= INPUT_KEY_LEFT;
+		}
+
+		if (AEInputCheckCurr(AEVK_RIGHT))
+		{
+			keys |= INPUT_KEY_RIGHT;
+		}
+
+		if (shootPending)
+		{
+			keys |= INPUT_KEY_SHOOT;
+			shootPending = false;
+		}
+
+		for (int i = INPUT_REDUNDANCY - 1; i > 0; --i)
+		{
+			inputKeys[i] = inputKeys[i - 1];
+		}
+		inputKeys[0] = keys;
+
+		SendEventToServer(assignedShipID, inputTick, inputKeys);
+		++inputTick;
 	}
 	
 	// ===================================================
@@ -604,6 +644,11 @@ void gameObjInstSet(int id, unsigned long type,
 		std::cout << "ISNULL\n";
 }
 
+void gameObjInstRemove(int id)
+{
+	gameObjInstDestroy(sGameObjInstList + id);
+}
+
 void resetNonGameObjs(int offset)
 {
 	std::cout << "resetting\n";
@@ -675,14 +720,32 @@ void gameObjInstDestroy(GameObjInst * pInst)
 	Sends an event to the server
 */
 /******************************************************************************/
-void SendEventToServer(int shipID, MESSAGE_TYPE messageType) {
+void SendEventToServer(int shipID, int tick, const unsigned char* keys) {
 	CLIENT_MESSAGE_FORMAT toSend{};
-	toSend.MessageType = static_cast<int>(messageType);
+	toSend.RoomID = assignedRoomID;
 	toSend.ShipID = shipID;
+	toSend.Tick = tick;
+	toSend.Ack = snapshotAcked;
+	for (int i = 0; i < INPUT_REDUNDANCY; ++i) {
+		toSend.Keys[i] = keys[i];
+	}
+
+	// the server steers it to its room by the room id, right after the header
+	static u32 sequence{};
+	u8 buffer[PROTOCOL_HEADER_SIZE + 12 + INPUT_REDUNDANCY];
+	PacketWriter writer;
+	PacketWriterInit(writer, buffer, sizeof(buffer));
+	PacketWriteHeader(writer, PACKET_INPUT, static_cast<u32>(toSend.Tick), sequence++);
+	PacketWriteU32(writer, static_cast<u32>(toSend.RoomID));
+	PacketWriteU32(writer, static_cast<u32>(toSend.ShipID));
+	PacketWriteU32(writer, toSend.Ack);
+	for (int i = 0; i < INPUT_REDUNDANCY; ++i) {
+		PacketWriteU8(writer, toSend.Keys[i]);
+	}
 
 	int errorCode = sendto(clientSocket, 
-		reinterpret_cast<const char*>(&toSend), 
-		sizeof(CLIENT_MESSAGE_FORMAT),
+		reinterpret_cast<const char*>(buffer), 
+		static_cast<int>(writer.size),
 		0, 
 		serverInfo->ai_addr,
 		static_cast<int>(serverInfo->ai_addrlen));
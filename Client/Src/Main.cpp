@@ -13,6 +13,8 @@ prior written consent of DigiPen Institute of Technology is prohibited.
  /******************************************************************************/
 
 #include "main.h"
+#include <algorithm>
+#include <vector>
 //#define PrintMessage
 
 // ---------------------------------------------------------------------------
@@ -25,6 +27,14 @@ std::string serverPort;
 addrinfo* serverInfo;
 SOCKET clientSocket;
 int assignedShipID;
+int assignedRoomID;
+int assignedTickRate;
+QuantizeConfig snapshotQuantize;
+std::atomic<u32> snapshotAcked{ SNAPSHOT_NONE };
+
+// snapshots received, the server sends the next ones as changes to them.
+// only the receive thread touches it
+static SnapshotHistory snapshotHistory;
 GAME_SCORE gameScore;
 std::mutex GAME_OBJECT_LIST_MUTEX;
 std::mutex GAME_SCORE_MUTEX;
@@ -183,9 +193,13 @@ int WinsockServerConnection() {
 		return 2;
 	}
 
-	// Send a test message
-	const char* message = "Client Connection";
-	errorCode = sendto(clientSocket, message, strlen(message), 0, serverInfo->ai_addr, static_cast<int>(serverInfo->ai_addrlen));
+	// Ask to join, the server picks the room
+	u8 message[PROTOCOL_HEADER_SIZE + 4];
+	PacketWriter writer;
+	PacketWriterInit(writer, message, sizeof(message));
+	PacketWriteHeader(writer, PACKET_JOIN, 0, 0);
+	PacketWriteU32(writer, 0xFFFFFFFF);
+	errorCode = sendto(clientSocket, reinterpret_cast<const char*>(message), static_cast<int>(writer.size), 0, serverInfo->ai_addr, static_cast<int>(serverInfo->ai_addrlen));
 	if (errorCode == SOCKET_ERROR) {
 		std::cerr << "sendto() failed: " << WSAGetLastError() << std::endl;
 		freeaddrinfo(serverInfo);
@@ -197,7 +211,7 @@ int WinsockServerConnection() {
 	std::cout << "Message sent successfully." << std::endl;
 
 	// Receive Ship ID from server
-	char buffer[sizeof(SERVER_INITIAL_MESSAGE_FORMAT)];
+	char buffer[PROTOCOL_HEADER_SIZE + 10 + sizeof(QuantizeConfig)];
 	sockaddr_in servAddr;
 	int servAddrLen = sizeof(servAddr);
 
@@ -208,10 +222,30 @@ int WinsockServerConnection() {
 		return 1;
 	}
 
-	SERVER_INITIAL_MESSAGE_FORMAT recv{ *reinterpret_cast<SERVER_INITIAL_MESSAGE_FORMAT*>(buffer) };
+	PacketReader reader;
+	PacketHeader header;
+	PacketReaderInit(reader, buffer, static_cast<unsigned int>(bytesRead));
+	if (!PacketReadHeader(reader, header) || header.type != PACKET_JOIN_REPLY) {
+		std::cerr << "The server speaks another protocol version." << std::endl;
+		return 1;
+	}
+
+	SERVER_INITIAL_MESSAGE_FORMAT recv{};
+	recv.ShipID = static_cast<int>(PacketReadU32(reader));
+	recv.RoomID = static_cast<int>(PacketReadU32(reader));
+	recv.TickRate = static_cast<int>(PacketReadU16(reader));
+	QuantizeRead(reader, snapshotQuantize);
+	if (reader.overflow) {
+		std::cerr << "The server sent a short join reply." << std::endl;
+		return 1;
+	}
+	SnapshotHistoryInit(snapshotHistory);
+	snapshotAcked = SNAPSHOT_NONE;
 	assignedShipID = recv.ShipID;
+	assignedRoomID = recv.RoomID;
+	assignedTickRate = recv.TickRate > 0 ? recv.TickRate : 60;
 
-	std::cout << "Assigned ID: " << assignedShipID << std::endl;
+	std::cout << "Assigned ID: " << assignedShipID << " Room: " << assignedRoomID << std::endl;
 
 	return 0;
 }
@@ -221,7 +255,7 @@ void ReceiveServerMessages(SOCKET clientSocket) {
 #ifdef PrintMessage
 		std::cout << "------------------------\n";
 #endif
-		char buffer[100000];
+		char buffer[PROTOCOL_FRAGMENT_SIZE];
 
 		sockaddr_in servAddr;
 		int servAddrLen = sizeof(servAddr);
@@ -230,15 +264,27 @@ void ReceiveServerMessages(SOCKET clientSocket) {
 			reinterpret_cast<sockaddr*>(&servAddr), &servAddrLen);
 		if (bytesRead == SOCKET_ERROR) {
 			std::cerr << "recvfrom() failed: " << WSAGetLastError() << std::endl;
+			continue;
+		}
+
+		// anything but a snapshot of our protocol version is dropped
+		PacketReader reader;
+		PacketHeader header;
+		PacketReaderInit(reader, buffer, static_cast<unsigned int>(bytesRead));
+		if (!PacketReadHeader(reader, header) || header.type != PACKET_SNAPSHOT) {
+			continue;
 		}
+
 		{
 			std::lock_guard<std::mutex> lock(GAME_OBJECT_LIST_MUTEX);
 			SetPackageInterval();
 		}
-		int numOfShips{};
-		int  numOfOtherObj{};
-		memcpy(&numOfShips, &buffer[0], sizeof(int));
-		memcpy(&numOfOtherObj, &buffer[sizeof(uint32_t)], sizeof(uint32_t));
+		unsigned int fragment{ PacketReadU8(reader) };
+		unsigned int fragmentCount{ PacketReadU8(reader) };
+		int numOfShips{ PacketReadU16(reader) };
+		u32 baselineSequence{ PacketReadU32(reader) };
+		if (fragment >= fragmentCount || fragmentCount > PROTOCOL_FRAGMENT_MAX)
+			continue;
 #ifdef PrintMessage
 		std::cout << "numOfShips: " << static_cast<int>(numOfShips) << "\n";
 #endif
@@ -248,10 +294,97 @@ void ReceiveServerMessages(SOCKET clientSocket) {
 		//}
 		SHIP_OBJ_INFO shipInfo{};
 		OTHER_OBJ_INFO otherObj{};
+		SnapshotEntity entity{};
+		EntityState state{};
+		BitReader bits;
+		BitReaderInit(bits, reader);
+		std::vector<SHIP_OBJ_INFO> ships(numOfShips);
+		for (SHIP_OBJ_INFO& ship : ships)
+		{
+			ship.dead = static_cast<int>(BitRead(bits, 1));
+			ship.live = static_cast<int>(BitRead(bits, PROTOCOL_LIVES_BITS));
+			ship.score = static_cast<int>(BitRead(bits, 32));
+			SnapshotReadEntity(bits, snapshotQuantize, state);
+			EntityStateDequantize(snapshotQuantize, state, entity);
+			ship.shipID = static_cast<int>(entity.slot);
+			ship.scale = entity.scale;
+			ship.position = AEVec2{ entity.posX, entity.posY };
+			ship.velCurr = AEVec2{ entity.velX, entity.velY };
+			ship.dirCurr = entity.dir;
+		}
+		if (reader.overflow)
+			continue;
+
+		// the objects are changes to a whole snapshot received before, one
+		// that is gone leaves them out until the server sends them whole again.
+		// the first fragment of a snapshot starts its frame, the others come
+		// in any order and each one updates the objects it carries
+		static std::vector<u32> shownObjects;
+		static u32 shownSequence{ SNAPSHOT_NONE };
+		SnapshotFrame* frame = &snapshotHistory.frames[header.sequence & (PROTOCOL_SNAPSHOT_HISTORY - 1)];
+		if (frame->sequence != header.sequence) {
+			SnapshotFrame* baseline = SnapshotHistoryBaseline(snapshotHistory, baselineSequence, header.sequence);
+			if (frame->sequence != SNAPSHOT_NONE && static_cast<s32>(header.sequence - frame->sequence) < 0)
+				frame = nullptr;
+			else if (baselineSequence != SNAPSHOT_NONE && (!baseline || !SnapshotFrameComplete(*baseline)))
+				frame = nullptr;
+			else {
+				frame = &SnapshotHistoryAdd(snapshotHistory, header.sequence, header.tick);
+				SnapshotFrameStart(snapshotQuantize, baseline, *frame);
+				frame->fragments = fragmentCount;
+			}
+		}
+
+		// a frame a bad fragment broke has no fragments left to take
+		u64 fragmentBit = static_cast<u64>(1) << fragment;
+		if (frame && (frame->fragments != fragmentCount || (frame->received & fragmentBit)))
+			frame = nullptr;
+		if (frame) {
+			if (SnapshotReadFragment(bits, snapshotQuantize, *frame)) {
+				frame->received |= fragmentBit;
+			}
+			else {
+				frame->fragments = 0;
+				frame->objects.clear();
+				frame = nullptr;
+			}
+		}
+
+		// only a whole snapshot is a baseline
+		if (frame && SnapshotFrameComplete(*frame)
+			&& (snapshotHistory.acked == SNAPSHOT_NONE || static_cast<s32>(header.sequence - snapshotHistory.acked) > 0)) {
+			snapshotHistory.acked = header.sequence;
+			snapshotAcked = header.sequence;
+		}
+
+		// the newest snapshot is shown as its fragments come in, one that
+		// came late is not
+		if (frame && shownSequence != SNAPSHOT_NONE && static_cast<s32>(header.sequence - shownSequence) < 0)
+			frame = nullptr;
+		if (frame) {
+			// objects the server stopped sending are gone, unless a ship took the slot
+			std::lock_guard<std::mutex> lock(GAME_OBJECT_LIST_MUTEX);
+			size_t o = 0;
+			for (u32 slot : shownObjects) {
+				while (o < frame->objects.size() && frame->objects[o].slot < slot)
+					o++;
+				bool ship = std::any_of(ships.begin(), ships.end(),
+					[slot](const SHIP_OBJ_INFO& s) { return static_cast<u32>(s.shipID) == slot; });
+				if (!ship && (o == frame->objects.size() || frame->objects[o].slot != slot))
+					gameObjInstRemove(static_cast<int>(slot));
+			}
+
+			shownObjects.clear();
+			for (const EntityState& object : frame->objects)
+				shownObjects.push_back(object.slot);
+			shownSequence = header.sequence;
+		}
+
 		for (int i = 0; i < numOfShips; ++i)
 		{
-			memcpy(&shipInfo, &buffer[8 + (i*sizeof(SHIP_OBJ_INFO))], sizeof(SHIP_OBJ_INFO));
-			if ( i == assignedShipID ){
+			shipInfo = ships[i];
+
+			if (shipInfo.shipID == EntityIndex(assignedShipID)) {
 				std::lock_guard<std::mutex> lock(GAME_SCORE_MUTEX);
 				gameScore.isDead = shipInfo.dead;
 				gameScore.score = shipInfo.score;
@@ -289,9 +422,19 @@ void ReceiveServerMessages(SOCKET clientSocket) {
 #endif
 		}
 
-		for (int i = 0; i < numOfOtherObj; ++i)
+		if (!frame)
+			continue;
+
+		for (const EntityState& object : frame->objects)
 		{
-			memcpy(&otherObj, &buffer[8 + (numOfShips * sizeof(SHIP_OBJ_INFO)) + (i*sizeof(OTHER_OBJ_INFO))], sizeof(OTHER_OBJ_INFO));
+			EntityStateDequantize(snapshotQuantize, object, entity);
+			otherObj.objID = static_cast<int>(entity.slot);
+			otherObj.type = entity.type;
+			otherObj.scale = entity.scale;
+			otherObj.position = AEVec2{ entity.posX, entity.posY };
+			otherObj.velCurr = AEVec2{ entity.velX, entity.velY };
+			otherObj.dirCurr = entity.dir;
+
 			std::lock_guard<std::mutex> lock(GAME_OBJECT_LIST_MUTEX);
 			
 			//if (otherObj.type == TYPE_BULLET) {
@@ -0,0 +1,921 @@
+/******************************************************************************/
+/*!
+\file			ServerBench.cpp
+\author
+\par
+\date
+\brief		This is the server benchmark. Every section times one part of the
+					tick on synthetic data and prints a table, run it with the names
+					of the sections wanted or with none for all of them. The times
+					are the best of a few runs, per entity or per tick. The shards
+					section instead runs the whole server on loopback for a few
+					seconds and counts what got through.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "GameState_Asteroids.h"
+#include "SimKernel.h"
+#include "Broadphase.h"
+#include "Narrowphase.h"
+#include "Room.h"
+#include "Shard.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+typedef std::chrono::steady_clock BenchClock;
+
+const unsigned int	BENCH_RUNS = 5;												// the best one counts
+const f64						BENCH_RUN_SECONDS = 0.2;							// each run repeats the work at least this long
+const unsigned int	BENCH_COUNTS[] = { 2000, 20000, 200000 };		// entities of a scene
+const f32						BENCH_DT = 1.0f / 60.0f;
+const SimBounds			BENCH_BOUNDS{ -400.0f, 400.0f, -300.0f, 300.0f };
+
+// the shards section runs real shards on loopback with synthetic players
+const char* const		BENCH_SHARD_PORT = "47815";
+const unsigned int	BENCH_SHARD_CLIENTS = 1000;						// g_roomPlayers to a room, one shard opens ROOM_NUM_MAX
+const f64						BENCH_SHARD_WARMUP = 2.0;							// seconds for the rooms to fill with bullets
+const f64						BENCH_SHARD_SECONDS = 3.0;						// seconds measured
+const unsigned int	BENCH_SHARD_BURST = 16;								// datagrams sent back to back
+const unsigned int	BENCH_SHARD_JOIN_RETRY = 6;						// ticks between two joins of a player without a room
+
+// a crowded scene: its rows, the asteroids are the queries of the
+// broadphase and everything else its targets
+struct BenchScene
+{
+	EntityStore									store;
+	SimBounds										bounds;
+	std::vector<unsigned int>		queries;
+	std::vector<unsigned int>		targets;
+	unsigned int								calls;		// ticks run, every other one runs backwards
+};
+
+// a player the shards section makes up, it joins and then holds shoot and
+// left every tick so its room fills with bullets
+struct BenchClient
+{
+	SOCKET				socket;
+	u32						room;
+	u32						ship;
+	u32						ack;					// newest snapshot it got, sent back like a client does
+	u32						tick;					// of its next input
+	bool					joined;
+	u64						received;			// snapshot fragments
+};
+
+struct BenchSection
+{
+	const char*		name;
+	const char*		what;
+	void					(*run)();
+};
+
+// a game object instance as the server kept them before the entity store,
+// one struct per object with everything in it
+struct BenchObj
+{
+	unsigned long		type;
+	void*						pMesh;
+};
+
+struct BenchObjInst
+{
+	BenchObj*				pObject;
+	unsigned long		flag;
+	float						scale;
+	AEVec2					posCurr;
+	AEVec2					velCurr;
+	float						dirCurr;
+	AABB						boundingBox;
+	float						transform[3][3];
+	int							fromShipIdx;
+};
+
+/******************************************************************************/
+/*!
+	Seconds one call of work takes, the best of BENCH_RUNS runs that each
+	repeat it for at least BENCH_RUN_SECONDS
+*/
+/******************************************************************************/
+template <typename Work>
+static f64 BenchTime(Work work)
+{
+	f64 best = std::numeric_limits<f64>::max();
+	for (unsigned int run = 0; run < BENCH_RUNS; run++)
+	{
+		unsigned int calls = 0;
+		BenchClock::time_point start = BenchClock::now();
+		f64 elapsed;
+		do
+		{
+			work();
+			calls++;
+			elapsed = std::chrono::duration<f64>(BenchClock::now() - start).count();
+		} while (elapsed < BENCH_RUN_SECONDS);
+
+		if (elapsed / calls < best)
+			best = elapsed / calls;
+	}
+	return best;
+}
+
+/******************************************************************************/
+/*!
+	count rows of ships, bullets and asteroids spread over the world, moving
+	at up to ship speed, with their sizes and wrap margins
+*/
+/******************************************************************************/
+static void BenchFillStore(EntityStore& store, unsigned int count, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<f32> x(BENCH_BOUNDS.minX, BENCH_BOUNDS.maxX);
+	std::uniform_real_distribution<f32> y(BENCH_BOUNDS.minY, BENCH_BOUNDS.maxY);
+	std::uniform_real_distribution<f32> v(-240.0f, 240.0f);
+	const f32 scales[TYPE_NUM] = { SHIP_SIZE, BULLET_SIZE, ASTEROID_SIZE };
+	const f32 margins[TYPE_NUM] = { SHIP_SIZE, std::numeric_limits<f32>::infinity(), BOUNDING_RECT_SIZE * ASTEROID_SIZE };
+
+	EntityStoreInit(store, count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		AEVec2 pos{ x(random), y(random) };
+		AEVec2 vel{ v(random), v(random) };
+		EntityHandle handle = EntityCreate(store, i % TYPE_NUM, scales[i % TYPE_NUM], &pos, &vel, 0.0f);
+		store.wrapMargin[EntityRow(store, handle)] = margins[i % TYPE_NUM];
+	}
+}
+
+/******************************************************************************/
+/*!
+	The same objects as an array of instances, one shared BenchObj per type
+*/
+/******************************************************************************/
+static void BenchFillInstances(std::vector<BenchObjInst>& instances, BenchObj* objects, const EntityStore& store)
+{
+	instances.assign(store.count, BenchObjInst{});
+	for (unsigned int i = 0; i < store.count; i++)
+	{
+		BenchObjInst& inst = instances[i];
+		inst.pObject = objects + store.type[i];
+		inst.flag = 1;
+		inst.scale = store.scale[i];
+		inst.posCurr = { store.posX[i], store.posY[i] };
+		inst.velCurr = { store.velX[i], store.velY[i] };
+		inst.dirCurr = store.dir[i];
+	}
+}
+
+/******************************************************************************/
+/*!
+	One tick of the passes the server ran over its instances before the
+	entity store: bounds and integrate, then wrap by type. The out of bounds
+	bullets are only counted, so every tick does the same work
+*/
+/******************************************************************************/
+static unsigned int BenchTickInstances(std::vector<BenchObjInst>& instances, f32 dt)
+{
+	const SimBounds& b = BENCH_BOUNDS;
+
+	for (BenchObjInst& inst : instances)
+	{
+		if ((inst.flag & 1) == 0)
+			continue;
+
+		inst.boundingBox.min.x = inst.posCurr.x - BOUNDING_RECT_SIZE / 2.0f * inst.scale;
+		inst.boundingBox.min.y = inst.posCurr.y - BOUNDING_RECT_SIZE / 2.0f * inst.scale;
+		inst.boundingBox.max.x = inst.posCurr.x + BOUNDING_RECT_SIZE / 2.0f * inst.scale;
+		inst.boundingBox.max.y = inst.posCurr.y + BOUNDING_RECT_SIZE / 2.0f * inst.scale;
+
+		inst.posCurr = { inst.velCurr.x * dt + inst.posCurr.x, inst.velCurr.y * dt + inst.posCurr.y };
+	}
+
+	unsigned int culled = 0;
+	for (BenchObjInst& inst : instances)
+	{
+		if ((inst.flag & 1) == 0)
+			continue;
+
+		if (inst.pObject->type == TYPE_SHIP) {
+			inst.posCurr.x = PlatformWrap(inst.posCurr.x, b.minX - SHIP_SIZE, b.maxX + SHIP_SIZE);
+			inst.posCurr.y = PlatformWrap(inst.posCurr.y, b.minY - SHIP_SIZE, b.maxY + SHIP_SIZE);
+		}
+		if (inst.pObject->type == TYPE_ASTEROID) {
+			f32 margin = BOUNDING_RECT_SIZE * inst.scale;
+			inst.posCurr.x = PlatformWrap(inst.posCurr.x, b.minX - margin, b.maxX + margin);
+			inst.posCurr.y = PlatformWrap(inst.posCurr.y, b.minY - margin, b.maxY + margin);
+		}
+		if (inst.pObject->type == TYPE_BULLET) {
+			if (inst.posCurr.x < b.minX || inst.posCurr.x > b.maxX || inst.posCurr.y > b.maxY || inst.posCurr.y < b.minY)
+				culled++;
+		}
+	}
+	return culled;
+}
+
+/******************************************************************************/
+/*!
+	Bounds, integrate and wrap for one tick, the old array of instances
+	against the entity store with the scalar and the widest kernel
+*/
+/******************************************************************************/
+static void BenchStore()
+{
+	SIM_KERNEL_ISA widest = SimKernelGetIsa();
+	std::printf("%10s %10s %10s %10s   ns per entity, speedup over instances\n",
+		"entities", "instances", "store", SimKernelGetIsaName(widest));
+
+	for (unsigned int count : BENCH_COUNTS)
+	{
+		EntityStore store;
+		BenchFillStore(store, count, count);
+
+		BenchObj objects[TYPE_NUM] = { { TYPE_SHIP, nullptr }, { TYPE_BULLET, nullptr }, { TYPE_ASTEROID, nullptr } };
+		std::vector<BenchObjInst> instances;
+		BenchFillInstances(instances, objects, store);
+
+		volatile unsigned int culled = 0;
+		f64 aos = BenchTime([&]() { culled = culled + BenchTickInstances(instances, BENCH_DT); });
+
+		SimKernelInit(SIM_KERNEL_SCALAR);
+		f64 soa = BenchTime([&]() {
+			SimKernelIntegrateWrap(store, 0, store.count, BENCH_DT, BOUNDING_RECT_SIZE / 2.0f, BENCH_BOUNDS);
+		});
+		SimKernelInit(widest);
+		f64 simd = BenchTime([&]() {
+			SimKernelIntegrateWrap(store, 0, store.count, BENCH_DT, BOUNDING_RECT_SIZE / 2.0f, BENCH_BOUNDS);
+		});
+
+		std::printf("%10u %5.2f 1.0x %5.2f %3.1fx %5.2f %3.1fx\n", count,
+			aos * 1e9 / count, soa * 1e9 / count, aos / soa, simd * 1e9 / count, aos / simd);
+	}
+}
+
+/******************************************************************************/
+/*!
+	The tick as three sweeps over the store, the way it ran before the
+	fused kernel: bounds, then integrate, then wrap or cull by type. Returns
+	the bullets that left the world
+*/
+/******************************************************************************/
+static unsigned int BenchMultiPass(EntityStore& e, f32 dt, f32 halfExtent, const SimBounds& b)
+{
+	for (unsigned int i = 0; i < e.count; i++)
+	{
+		f32 halfSize = halfExtent * e.scale[i];
+		e.minX[i] = e.posX[i] - halfSize;
+		e.minY[i] = e.posY[i] - halfSize;
+		e.maxX[i] = e.posX[i] + halfSize;
+		e.maxY[i] = e.posY[i] + halfSize;
+	}
+
+	for (unsigned int i = 0; i < e.count; i++)
+	{
+		e.posX[i] = e.velX[i] * dt + e.posX[i];
+		e.posY[i] = e.velY[i] * dt + e.posY[i];
+	}
+
+	unsigned int culled = 0;
+	for (unsigned int i = 0; i < e.count; i++)
+	{
+		if (e.type[i] == TYPE_BULLET) {
+			if (e.posX[i] < b.minX || e.posX[i] > b.maxX || e.posY[i] > b.maxY || e.posY[i] < b.minY)
+				culled++;
+			continue;
+		}
+
+		f32 margin = e.wrapMargin[i];
+		e.posX[i] = PlatformWrap(e.posX[i], b.minX - margin, b.maxX + margin);
+		e.posY[i] = PlatformWrap(e.posY[i], b.minY - margin, b.maxY + margin);
+	}
+	return culled;
+}
+
+/******************************************************************************/
+/*!
+	Three sweeps against the fused one, both scalar so only the memory
+	traffic differs. The bytes are what each version reads and writes per
+	row: the sweeps load the positions three times and store them twice
+*/
+/******************************************************************************/
+static void BenchFused()
+{
+	// bounds: pos, scale in, box out. integrate: pos, vel in, pos out.
+	// wrap: pos, type, margin in, pos out
+	const unsigned int multiBytes = (12 + 16) + (16 + 8) + (13 + 8);
+	// pos, vel, scale, margin in, box and pos out
+	const unsigned int fusedBytes = 24 + 24;
+
+	std::printf("%10s %10s %10s %12s %12s   ns per entity, speedup, MB swept per tick\n",
+		"entities", "passes", "fused", "passes MB", "fused MB");
+
+	SIM_KERNEL_ISA widest = SimKernelGetIsa();
+	SimKernelInit(SIM_KERNEL_SCALAR);
+	for (unsigned int count : BENCH_COUNTS)
+	{
+		EntityStore store;
+		BenchFillStore(store, count, count);
+
+		volatile unsigned int culled = 0;
+		f64 multi = BenchTime([&]() {
+			culled = culled + BenchMultiPass(store, BENCH_DT, BOUNDING_RECT_SIZE / 2.0f, BENCH_BOUNDS);
+		});
+		f64 fused = BenchTime([&]() {
+			SimKernelIntegrateWrap(store, 0, store.count, BENCH_DT, BOUNDING_RECT_SIZE / 2.0f, BENCH_BOUNDS);
+		});
+
+		std::printf("%10u %5.2f 1.0x %5.2f %3.1fx %12.2f %12.2f\n", count,
+			multi * 1e9 / count, fused * 1e9 / count, multi / fused,
+			multiBytes * count / 1e6, fusedBytes * count / 1e6);
+	}
+	SimKernelInit(widest);
+}
+
+/******************************************************************************/
+/*!
+	Integrate and wrap, the scalar per row loop against the SIMD kernels
+*/
+/******************************************************************************/
+static void BenchKernel()
+{
+	const SIM_KERNEL_ISA isas[] = { SIM_KERNEL_SCALAR, SIM_KERNEL_SSE2, SIM_KERNEL_AVX2 };
+
+	std::printf("%10s", "entities");
+	for (SIM_KERNEL_ISA isa : isas)
+		std::printf(" %10s", SimKernelGetIsaName(isa));
+	std::printf("   ns per entity, speedup over scalar\n");
+
+	for (unsigned int count : BENCH_COUNTS)
+	{
+		EntityStore store;
+		BenchFillStore(store, count, count);
+
+		std::printf("%10u", count);
+		f64 scalar = 0.0;
+		for (SIM_KERNEL_ISA isa : isas)
+		{
+			SimKernelInit(isa);
+			if (SimKernelGetIsa() != isa) {
+				std::printf(" %10s", "-");
+				continue;
+			}
+
+			f64 seconds = BenchTime([&]() {
+				SimKernelIntegrateWrap(store, 0, store.count, BENCH_DT, BOUNDING_RECT_SIZE / 2.0f, BENCH_BOUNDS);
+			});
+			if (isa == SIM_KERNEL_SCALAR)
+				scalar = seconds;
+			std::printf(" %5.2f %3.1fx", seconds * 1e9 / count, scalar / seconds);
+		}
+		std::printf("\n");
+	}
+	SimKernelInit();
+}
+
+/******************************************************************************/
+/*!
+	ships, asteroids and bullets over bounds, half the bullets bunched up
+	around the ships the way a fight looks and the rest anywhere, so the
+	density is very uneven. Every type has its real size, speed and wrap margin
+*/
+/******************************************************************************/
+static void BenchFillCrowd(BenchScene& scene, const SimBounds& bounds, unsigned int ships,
+													 unsigned int asteroids, unsigned int bullets, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<f32> x(bounds.minX, bounds.maxX);
+	std::uniform_real_distribution<f32> y(bounds.minY, bounds.maxY);
+	std::uniform_real_distribution<f32> heading(-PI, PI);
+	std::normal_distribution<f32> spread(0.0f, 2.0f * SHIP_SIZE);
+
+	EntityStore& e = scene.store;
+	EntityStoreInit(e, ships + asteroids + bullets);
+	scene.bounds = bounds;
+	scene.queries.clear();
+	scene.targets.clear();
+	scene.calls = 0;
+
+	std::vector<AEVec2> shipPos;
+	for (unsigned int i = 0; i < ships; i++)
+	{
+		AEVec2 pos{ x(random), y(random) };
+		AEVec2 vel{ 0.0f, 0.0f };
+		EntityHandle h = EntityCreate(e, TYPE_SHIP, SHIP_SIZE, &pos, &vel, heading(random));
+		e.wrapMargin[EntityRow(e, h)] = SHIP_SIZE;
+		shipPos.push_back(pos);
+	}
+
+	for (unsigned int i = 0; i < asteroids; i++)
+	{
+		f32 dir = heading(random);
+		AEVec2 pos{ x(random), y(random) };
+		AEVec2 vel{ cosf(dir) * ASTEROID_SPEED, sinf(dir) * ASTEROID_SPEED };
+		EntityHandle h = EntityCreate(e, TYPE_ASTEROID, ASTEROID_SIZE, &pos, &vel, 0.0f);
+		e.wrapMargin[EntityRow(e, h)] = BOUNDING_RECT_SIZE * ASTEROID_SIZE;
+	}
+
+	for (unsigned int i = 0; i < bullets; i++)
+	{
+		f32 dir = heading(random);
+		AEVec2 pos{ x(random), y(random) };
+		if (i % 2 == 0 && ships > 0) {
+			const AEVec2& ship = shipPos[random() % ships];
+			pos = { ship.x + spread(random), ship.y + spread(random) };
+		}
+		AEVec2 vel{ cosf(dir) * BULLET_SPEED, sinf(dir) * BULLET_SPEED };
+		EntityCreate(e, TYPE_BULLET, BULLET_SIZE, &pos, &vel, dir);
+	}
+
+	for (unsigned int i = 0; i < e.count; i++)
+		(e.type[i] == TYPE_ASTEROID ? scene.queries : scene.targets).push_back(i);
+}
+
+/******************************************************************************/
+/*!
+	One collision tick of the scene: integrate, find the pairs and run the
+	narrowphase on them. It runs backwards every other time, so the crowd
+	stays where it is however often it is timed. Returns the hits
+*/
+/******************************************************************************/
+static unsigned int BenchCollide(BenchScene& scene, BroadphaseContext& context, std::vector<BroadphasePair>& pairs)
+{
+	EntityStore& e = scene.store;
+	f32 dt = (scene.calls++ & 1) ? -BENCH_DT : BENCH_DT;
+
+	SimKernelIntegrateWrap(e, 0, e.count, dt, BOUNDING_RECT_SIZE / 2.0f, scene.bounds);
+	BroadphaseFindPairs(context, e, dt, scene.bounds, scene.queries, scene.targets, pairs);
+
+	unsigned int hits = 0;
+	for (const BroadphasePair& pair : pairs)
+	{
+		unsigned int q = pair.query, t = pair.target;
+		AABB		queryBox{ { e.minX[q] + pair.offset.x, e.minY[q] + pair.offset.y },
+			{ e.maxX[q] + pair.offset.x, e.maxY[q] + pair.offset.y } };
+		AABB		targetBox{ { e.minX[t], e.minY[t] }, { e.maxX[t], e.maxY[t] } };
+		hits += CollisionIntersection_RectRect(queryBox, { e.velX[q], e.velY[q] },
+			targetBox, { e.velX[t], e.velY[t] }, dt) ? 1 : 0;
+	}
+	return hits;
+}
+
+/******************************************************************************/
+/*!
+	Milliseconds of one collision tick of the scene with a backend, and the
+	pairs it hands to the narrowphase
+*/
+/******************************************************************************/
+static f64 BenchBroadphaseTime(BenchScene& scene, BROADPHASE_TYPE type, size_t& pairCount)
+{
+	BroadphaseInit(type, ASTEROID_SIZE);
+	BroadphaseContext* context = BroadphaseCreate();
+	std::vector<BroadphasePair> pairs;
+
+	volatile unsigned int hits = 0;
+	f64 seconds = BenchTime([&]() { hits = hits + BenchCollide(scene, *context, pairs); });
+	pairCount = pairs.size();
+
+	BroadphaseDestroy(context);
+	return seconds * 1e3;
+}
+
+/******************************************************************************/
+/*!
+	Grid against brute force, thousands of bullets and hundreds of asteroids
+*/
+/******************************************************************************/
+static void BenchGrid()
+{
+	const unsigned int scenes[][3] = { { 8, 200, 2000 }, { 16, 400, 4000 }, { 32, 800, 8000 } };
+
+	std::printf("%6s %9s %7s %11s %11s %9s %9s   ms per tick, speedup, narrowphase pairs\n",
+		"ships", "asteroids", "bullets", "brute", "grid", "brute", "grid");
+
+	for (const unsigned int* counts : scenes)
+	{
+		BenchScene scene;
+		BenchFillCrowd(scene, BENCH_BOUNDS, counts[0], counts[1], counts[2], counts[2]);
+
+		size_t brutePairs, gridPairs;
+		f64 brute = BenchBroadphaseTime(scene, BROADPHASE_BRUTE, brutePairs);
+		f64 grid = BenchBroadphaseTime(scene, BROADPHASE_GRID, gridPairs);
+
+		std::printf("%6u %9u %7u %6.2f 1.0x %6.2f %3.0fx %9zu %9zu\n", counts[0], counts[1], counts[2],
+			brute, grid, brute / grid, brutePairs, gridPairs);
+	}
+}
+
+/******************************************************************************/
+/*!
+	The crowded scene at count entities, the world grows with them so the
+	crowd stays as dense as at 2k: one in ten is an asteroid, one in two
+	hundred a ship and the rest bullets
+*/
+/******************************************************************************/
+static void BenchFillGrowingCrowd(BenchScene& scene, unsigned int count)
+{
+	f32 grow = std::sqrt(static_cast<f32>(count) / BENCH_COUNTS[0]);
+	SimBounds bounds{ BENCH_BOUNDS.minX * grow, BENCH_BOUNDS.maxX * grow, BENCH_BOUNDS.minY * grow, BENCH_BOUNDS.maxY * grow };
+	unsigned int asteroids = count / 10;
+	unsigned int ships = count / 200;
+
+	BenchFillCrowd(scene, bounds, ships, asteroids, count - asteroids - ships, count);
+}
+
+/******************************************************************************/
+/*!
+	Brute force, grid and sort and sweep on the growing crowd. Brute force
+	is left out once it would take seconds a tick
+*/
+/******************************************************************************/
+static void BenchBroadphase()
+{
+	const f64 bruteTestsMax = 1e8;		// query and target pairs brute force still runs
+
+	std::printf("%10s", "entities");
+	for (unsigned int type = 0; type < BROADPHASE_TYPE_NUM; type++)
+		std::printf(" %11s", BroadphaseGetTypeName(static_cast<BROADPHASE_TYPE>(type)));
+	std::printf(" %9s   ms per tick, speedup over brute force, narrowphase pairs\n", "pairs");
+
+	for (unsigned int count : BENCH_COUNTS)
+	{
+		BenchScene scene;
+		BenchFillGrowingCrowd(scene, count);
+
+		f64 ms[BROADPHASE_TYPE_NUM]{};
+		size_t pairs = 0;
+		for (unsigned int type = 0; type < BROADPHASE_TYPE_NUM; type++)
+		{
+			if (type == BROADPHASE_BRUTE && static_cast<f64>(scene.queries.size()) * scene.targets.size() > bruteTestsMax)
+				continue;
+			ms[type] = BenchBroadphaseTime(scene, static_cast<BROADPHASE_TYPE>(type), pairs);
+		}
+
+		std::printf("%10u", count);
+		for (unsigned int type = 0; type < BROADPHASE_TYPE_NUM; type++)
+		{
+			if (ms[type] == 0.0)
+				std::printf(" %11s", "-");
+			else if (ms[BROADPHASE_BRUTE] == 0.0)
+				std::printf(" %6.2f %4s", ms[type], "");
+			else
+				std::printf(" %6.2f %3.0fx", ms[type], ms[BROADPHASE_BRUTE] / ms[type]);
+		}
+		std::printf(" %9zu\n", pairs);
+	}
+	BroadphaseInit(BROADPHASE_GRID, ASTEROID_SIZE);
+}
+
+/******************************************************************************/
+/*!
+	DetectCollisions on the pairs of one tick of the crowd, with more and
+	more job workers. The events are the same for every count, see
+	narrowphase_test, only the time changes
+*/
+/******************************************************************************/
+static void BenchWorkers()
+{
+	const unsigned int workerCounts[] = { 0, 1, 3, 7, 15 };
+
+	std::printf("%10s %9s", "entities", "events");
+	for (unsigned int workers : workerCounts)
+		std::printf(" %7u+1", workers);
+	std::printf("   ms per tick, speedup over 0 workers, %u hardware threads\n", std::thread::hardware_concurrency());
+
+	for (unsigned int count : BENCH_COUNTS)
+	{
+		BenchScene scene;
+		BenchFillGrowingCrowd(scene, count);
+
+		// one tick of pairs, tested over and over
+		Room room{};
+		room.store = scene.store;
+		BroadphaseInit(BROADPHASE_GRID, ASTEROID_SIZE);
+		room.broadphase = BroadphaseCreate();
+		SimKernelIntegrateWrap(room.store, 0, room.store.count, BENCH_DT, BOUNDING_RECT_SIZE / 2.0f, scene.bounds);
+		BroadphaseFindPairs(*room.broadphase, room.store, BENCH_DT, scene.bounds, scene.queries, scene.targets, room.pairScratch);
+
+		std::printf("%10u", count);
+		f64 single = 0.0;
+		for (unsigned int workers : workerCounts)
+		{
+			JobSystemInit(workers);
+			f64 seconds = BenchTime([&]() { DetectCollisions(room, BENCH_DT); });
+			JobSystemExit();
+
+			if (workers == 0) {
+				single = seconds;
+				std::printf(" %9zu", room.eventScratch.size());
+			}
+			std::printf(" %5.2f %2.1fx", seconds * 1e3, single / seconds);
+		}
+		std::printf("\n");
+
+		BroadphaseDestroy(room.broadphase);
+	}
+}
+
+/******************************************************************************/
+/*!
+	One tick of every synthetic player. One in play sends its input, with
+	the keys of the ticks before it like a client, one still waiting for a
+	room asks again every few ticks, a join or its reply can get lost like
+	any datagram. Real players are not in step, so the datagrams go out a
+	few at a time over the whole tick: all at once they would overflow the
+	shard's socket, and the kernel would drop the same players every time
+*/
+/******************************************************************************/
+static void BenchClientsTick(std::vector<BenchClient>& clients, const addrinfo* server)
+{
+	BenchClock::duration const step = std::chrono::duration_cast<BenchClock::duration>(
+		std::chrono::duration<f64>(SimClockGetStep()));
+	BenchClock::time_point start = BenchClock::now();
+
+	u8 buffer[PROTOCOL_FRAGMENT_SIZE];
+	for (size_t c = 0; c < clients.size(); ++c)
+	{
+		BenchClient& client = clients[c];
+		if (c % BENCH_SHARD_BURST == 0)
+			std::this_thread::sleep_until(start + step * c / clients.size());
+
+		PacketWriter writer;
+		PacketWriterInit(writer, buffer, sizeof(buffer));
+		if (client.joined) {
+			PacketWriteHeader(writer, PACKET_INPUT, client.tick++, 0);
+			PacketWriteU32(writer, client.room);
+			PacketWriteU32(writer, client.ship);
+			PacketWriteU32(writer, client.ack);
+			for (int i = 0; i < INPUT_REDUNDANCY; ++i)
+				PacketWriteU8(writer, INPUT_KEY_SHOOT | INPUT_KEY_LEFT);
+		}
+		else if (client.tick++ % BENCH_SHARD_JOIN_RETRY == 0) {
+			PacketWriteHeader(writer, PACKET_JOIN, 0, 0);
+			PacketWriteU32(writer, ROOM_INVALID);
+		}
+		if (writer.size > 0) {
+			sendto(client.socket, reinterpret_cast<const char*>(buffer), static_cast<int>(writer.size), 0,
+				server->ai_addr, static_cast<int>(server->ai_addrlen));
+		}
+
+		while (PlatformNetWait(client.socket, 0.0))
+		{
+			int bytes = static_cast<int>(recv(client.socket, reinterpret_cast<char*>(buffer), sizeof(buffer), 0));
+			PacketReader reader;
+			PacketHeader header;
+			PacketReaderInit(reader, buffer, static_cast<unsigned int>(bytes > 0 ? bytes : 0));
+			if (!PacketReadHeader(reader, header))
+				continue;
+
+			if (header.type == PACKET_JOIN_REPLY && !client.joined) {
+				client.ship = PacketReadU32(reader);
+				client.room = PacketReadU32(reader);
+				client.joined = !reader.overflow;
+				client.tick = 0;
+			}
+			else if (header.type == PACKET_SNAPSHOT) {
+				client.received++;
+				if (client.ack == SNAPSHOT_NONE || static_cast<s32>(header.sequence - client.ack) > 0)
+					client.ack = header.sequence;
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+	Opens a socket for every synthetic player and runs ticks until the
+	shards found them all a room, or stopped letting more in, and returns
+	how many got one. The ones that are in play meanwhile, so their rooms
+	never go idle
+*/
+/******************************************************************************/
+static unsigned int BenchJoin(std::vector<BenchClient>& clients, const addrinfo* server)
+{
+	for (BenchClient& client : clients)
+	{
+		client = BenchClient{};
+		client.socket = socket(server->ai_family, server->ai_socktype, server->ai_protocol);
+		client.ack = SNAPSHOT_NONE;
+	}
+
+	// every join opens a room, a busy machine takes a while for all of them.
+	// give up once nobody got in for a few seconds
+	size_t joined = 0;
+	BenchClock::time_point progress = BenchClock::now();
+	while (joined < clients.size() && BenchClock::now() - progress < std::chrono::seconds(3))
+	{
+		BenchClientsTick(clients, server);
+
+		size_t now = std::count_if(clients.begin(), clients.end(), [](const BenchClient& client) { return client.joined; });
+		if (now > joined) {
+			joined = now;
+			progress = BenchClock::now();
+		}
+	}
+	return static_cast<unsigned int>(joined);
+}
+
+/******************************************************************************/
+/*!
+	The counters of every shard added up, and the room ticks they simulated:
+	every tick of a shard steps all of its rooms
+*/
+/******************************************************************************/
+static void BenchShardTotals(ShardStats& total, u64& roomTicks)
+{
+	total = ShardStats{};
+	roomTicks = 0;
+	for (unsigned int i = 0; i < ShardGetCount(); ++i)
+	{
+		ShardStats stats;
+		ShardGetStats(i, stats);
+		total.rooms += stats.rooms;
+		total.ticks += stats.ticks;
+		roomTicks += stats.ticks * stats.rooms;
+		total.tickMicroseconds += stats.tickMicroseconds;
+		total.packetsOut += stats.packetsOut;
+		total.bytesOut += stats.bytesOut;
+	}
+}
+
+/******************************************************************************/
+/*!
+	The whole server on loopback: ShardsOpen with more and more shards,
+	BENCH_SHARD_CLIENTS synthetic players that join and fire every tick, and
+	what the shards got through once their rooms are full of bullets. The
+	tick rate stays the server's, a shard that can not keep up simulates
+	fewer room ticks than the players ask for. The rest of the game state
+	reports on cout, it is quiet meanwhile
+*/
+/******************************************************************************/
+static void BenchShards()
+{
+	unsigned int hardware = std::max(2u, std::thread::hardware_concurrency());
+	PlatformInit(static_cast<unsigned int>(BENCH_BOUNDS.maxX - BENCH_BOUNDS.minX),
+		static_cast<unsigned int>(BENCH_BOUNDS.maxY - BENCH_BOUNDS.minY), g_tickRate);
+
+	// the shards alone take the cores, as the server does with several
+	g_workerCount = 0;
+	g_randomSeed = 1;
+
+	std::printf("%6s %7s %6s %12s %7s %8s %12s %9s %12s   %u players at %u Hz, %u hardware threads\n",
+		"shards", "players", "rooms", "room ticks/s", "of due", "us/room", "fragments/s", "MB/s out", "received/s",
+		BENCH_SHARD_CLIENTS, g_tickRate, std::thread::hardware_concurrency());
+
+	for (unsigned int shards = 1; shards <= hardware && shards <= SHARD_NUM_MAX; shards *= 2)
+	{
+		std::streambuf* out = std::cout.rdbuf(nullptr);
+		g_shardCount = shards;
+
+		addrinfo hints{};
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_DGRAM;
+		hints.ai_protocol = IPPROTO_UDP;
+		addrinfo* server = nullptr;
+		PlatformNetInit();
+		if (getaddrinfo("127.0.0.1", BENCH_SHARD_PORT, &hints, &server) != 0 || !server) {
+			std::cout.rdbuf(out);
+			std::cout.clear();
+			std::printf("getaddrinfo() failed\n");
+			PlatformNetExit();
+			return;
+		}
+
+		GameStateAsteroidsLoad();
+		if (ShardsOpen(g_shardCount, server) != 0) {
+			std::cout.rdbuf(out);
+			std::cout.clear();
+			std::printf("%6u shards do not open on port %s\n", shards, BENCH_SHARD_PORT);
+			freeaddrinfo(server);
+			GameStateAsteroidsUnload();
+			PlatformNetExit();
+			return;
+		}
+		GameStateAsteroidsInit();
+		ShardsStart();
+
+		std::vector<BenchClient> clients(BENCH_SHARD_CLIENTS);
+		unsigned int joined = BenchJoin(clients, server);
+
+		// the players keep the server's tick, warm up first so the rooms are
+		// as full as they get
+		BenchClock::duration const step = std::chrono::duration_cast<BenchClock::duration>(
+			std::chrono::duration<f64>(SimClockGetStep()));
+		BenchClock::time_point start = BenchClock::now();
+		BenchClock::time_point due = start;
+		BenchClock::time_point measured = start + std::chrono::duration_cast<BenchClock::duration>(
+			std::chrono::duration<f64>(BENCH_SHARD_WARMUP));
+		BenchClock::time_point end = measured + std::chrono::duration_cast<BenchClock::duration>(
+			std::chrono::duration<f64>(BENCH_SHARD_SECONDS));
+
+		ShardStats first{}, last{};
+		u64 roomTicksFirst = 0, roomTicksLast = 0;
+		u64 receivedFirst = 0, receivedLast = 0;
+		bool counting = false;
+		while (joined && BenchClock::now() < end)
+		{
+			BenchClientsTick(clients, server);
+			if (!counting && BenchClock::now() >= measured) {
+				counting = true;
+				BenchShardTotals(first, roomTicksFirst);
+				for (const BenchClient& client : clients)
+					receivedFirst += client.received;
+			}
+
+			due += step;
+			std::this_thread::sleep_until(due);
+		}
+		BenchShardTotals(last, roomTicksLast);
+		for (const BenchClient& client : clients)
+			receivedLast += client.received;
+		unsigned int opened = ShardGetCount();
+
+		ShardsStop();
+		for (BenchClient& client : clients)
+		{
+			if (client.socket != INVALID_SOCKET)
+				closesocket(client.socket);
+		}
+		GameStateAsteroidsFree();
+		GameStateAsteroidsUnload();
+		freeaddrinfo(server);
+		PlatformNetExit();
+
+		std::cout.rdbuf(out);
+		std::cout.clear();
+		if (!joined) {
+			std::printf("%6u no player got a room\n", opened);
+			continue;
+		}
+		if (last.rooms < first.rooms) {
+			std::printf("%6u rooms closed while measuring, their players went unheard\n", opened);
+			continue;
+		}
+
+		f64 seconds = BENCH_SHARD_SECONDS;
+		u64 roomTicks = roomTicksLast - roomTicksFirst;
+		f64 demand = static_cast<f64>(last.rooms) * g_tickRate;
+		std::printf("%6u %7u %6u %12.0f %6.0f%% %8.1f %12.0f %9.2f %12.0f\n",
+			opened, joined, last.rooms, roomTicks / seconds, demand > 0.0 ? roomTicks / seconds / demand * 100.0 : 0.0,
+			roomTicks ? static_cast<f64>(last.tickMicroseconds - first.tickMicroseconds) / roomTicks : 0.0,
+			(last.packetsOut - first.packetsOut) / seconds,
+			(last.bytesOut - first.bytesOut) / seconds / (1024.0 * 1024.0),
+			(receivedLast - receivedFirst) / seconds);
+	}
+}
+
+/******************************************************************************/
+/*!
+	Sections in the order they run
+*/
+/******************************************************************************/
+static const BenchSection sSections[] = {
+	{ "store", "one tick over the instance array and the entity store", BenchStore },
+	{ "fused", "bounds, integrate and wrap in three sweeps and in one", BenchFused },
+	{ "kernel", "integrate and wrap, per instruction set", BenchKernel },
+	{ "grid", "collision tick, grid broadphase against brute force", BenchGrid },
+	{ "broadphase", "collision tick of a growing crowd, per broadphase", BenchBroadphase },
+	{ "workers", "narrowphase of a growing crowd, per job worker count", BenchWorkers },
+	{ "shards", "players on loopback served by more and more shards", BenchShards },
+};
+
+int main(int argc, char* argv[])
+{
+	SimKernelInit();
+
+	bool ran = false;
+	for (const BenchSection& section : sSections)
+	{
+		bool wanted = argc < 2;
+		for (int i = 1; i < argc; i++)
+			wanted = wanted || std::strcmp(argv[i], section.name) == 0;
+		if (!wanted)
+			continue;
+
+		std::printf("== %s: %s\n", section.name, section.what);
+		section.run();
+		std::printf("\n");
+		ran = true;
+	}
+
+	if (!ran) {
+		std::fprintf(stderr, "Sections:");
+		for (const BenchSection& section : sSections)
+			std::fprintf(stderr, " %s", section.name);
+		std::fprintf(stderr, "\n");
+		return 1;
+	}
+	return 0;
+}
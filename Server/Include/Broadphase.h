@@ -0,0 +1,78 @@
+/******************************************************************************/
+/*!
+\file			Broadphase.h
+\author
+\par
+\date
+\brief		This is the collision broadphase header file. It turns the rows
+					of the entity store into the few query/target pairs whose boxes,
+					swept over one tick, can touch, so CollisionIntersection_RectRect
+					only runs on those. The world wraps: an entity whose box crosses
+					its wrap edge is also looked at as a ghost on the other side, one
+					wrap period away.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_BROADPHASE_H_
+#define ASS4_BROADPHASE_H_
+
+#include "EntityStore.h"
+#include "SimKernel.h"
+#include <vector>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+enum BROADPHASE_TYPE
+{
+	BROADPHASE_BRUTE = 0,		// every query against every target
+	BROADPHASE_GRID,				// uniform grid rebuilt every tick
+	BROADPHASE_SAP,					// sort and sweep on x, for very uneven crowds
+
+	BROADPHASE_TYPE_NUM
+};
+
+// candidate pair, both are rows of the entity store. the query box has to be
+// moved by offset before the narrowphase, it is zero unless the pair only
+// meets across a wrap edge
+struct BroadphasePair
+{
+	unsigned int query;
+	unsigned int target;
+	AEVec2			 offset;
+};
+
+// grid and sort and sweep state kept from tick to tick, one per world
+struct BroadphaseContext;
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// picks the backend, cellSize is the grid cell edge and should be about the
+// size of the largest entity
+void BroadphaseInit(BROADPHASE_TYPE type, f32 cellSize);
+
+// state for one more world, set up for the backend picked by BroadphaseInit
+BroadphaseContext* BroadphaseCreate();
+void BroadphaseDestroy(BroadphaseContext* context);
+
+BROADPHASE_TYPE BroadphaseGetType();
+const char* BroadphaseGetTypeName(BROADPHASE_TYPE type);
+
+// fills pairs with every (query, target, offset) whose boxes can meet during
+// dt, sorted by query row, target row then offset so the result never depends
+// on the backend. bounds are the world edges, every row wraps over them pushed
+// out by its wrapMargin. entities outside the edges are still found
+void BroadphaseFindPairs(BroadphaseContext& context, const EntityStore& store,
+												 f32 dt, const SimBounds& bounds,
+												 const std::vector<unsigned int>& queries,
+												 const std::vector<unsigned int>& targets,
+												 std::vector<BroadphasePair>& pairs);
+
+#endif // ASS4_BROADPHASE_H_
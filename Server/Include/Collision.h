@@ -17,7 +17,7 @@ prior written consent of DigiPen Institute of Technology is prohibited.
 #ifndef ASS4_COLLISION_H_
 #define ASS4_COLLISION_H_
 
-#include "AEEngine.h"
+#include "Platform.h"
 
 /**************************************************************************/
 /*!
@@ -33,8 +33,18 @@ struct AABB
 	AEVec2	max;
 };
 
+// dt is the length of the tick the boxes move over
 bool CollisionIntersection_RectRect(const AABB & aabb1, const AEVec2 & vel1, 
-									const AABB & aabb2, const AEVec2 & vel2);
+									const AABB & aabb2, const AEVec2 & vel2, float dt);
+
+// aabb1/vel1 against count candidates given as separate arrays, same rules as
+// CollisionIntersection_RectRect. hits[i] is set to 1 or 0 for candidate i,
+// the return value is the number of hits. 4 or 8 candidates are tested at
+// once when the simulation kernel runs SSE2 or AVX2
+unsigned int CollisionIntersection_RectRectBatch(const AABB & aabb1, const AEVec2 & vel1,
+									const float* minX, const float* minY, const float* maxX, const float* maxY,
+									const float* velX, const float* velY, unsigned int count, float dt,
+									unsigned char* hits);
 
 
 #endif // ASS4_COLLISION_H_
\ No newline at end of file
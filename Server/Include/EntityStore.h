@@ -0,0 +1,119 @@
+/******************************************************************************/
+/*!
+\file			EntityStore.h
+\author
+\par
+\date
+\brief		This is the entity store header file. Every field of a game object
+					instance lives in its own contiguous array (structure of arrays).
+					Live entities are packed into rows 0 to count - 1, so a pass walks
+					the arrays front to back with no holes and can work on several
+					rows at once. Rows move when entities are destroyed, outside code
+					keeps an EntityHandle and looks the row up.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_ENTITY_STORE_H_
+#define ASS4_ENTITY_STORE_H_
+
+#include "Platform.h"
+#include <vector>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+
+// stable id of an entity: slot index in the low bits, slot generation above it
+typedef u32 EntityHandle;
+
+const unsigned int	ENTITY_INDEX_BITS = 20;														// up to 1M slots
+const u32						ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+const u32						ENTITY_GENERATION_MASK = (1u << (32 - ENTITY_INDEX_BITS)) - 1;
+const EntityHandle	ENTITY_INVALID = 0xFFFFFFFFu;											// never issued
+const unsigned int	ENTITY_ROW_NONE = 0xFFFFFFFFu;										// row of a free slot
+
+/******************************************************************************/
+/*!
+	Struct/Class Definitions
+*/
+/******************************************************************************/
+
+// per row arrays hold the live entities packed at the front, per slot arrays
+// are indexed by the slot of a handle
+struct EntityStore
+{
+	unsigned int								capacity;	// number of slots and rows
+	unsigned int								count;		// number of live entities, rows 0 to count - 1
+
+	// per row
+	std::vector<float>					posX;			// current position
+	std::vector<float>					posY;
+	std::vector<float>					velX;			// current velocity
+	std::vector<float>					velY;
+	std::vector<float>					dir;			// current direction
+	std::vector<float>					scale;		// scaling value
+	std::vector<float>					wrapMargin;	// distance past the world edge before wrapping, infinite never wraps
+
+	std::vector<float>					minX;			// bounding box, refreshed every tick
+	std::vector<float>					minY;
+	std::vector<float>					maxX;
+	std::vector<float>					maxY;
+
+	std::vector<unsigned char>	type;			// object type
+	std::vector<int>						owner;		// ship table entry of a ship, or of the ship that fired a bullet
+	std::vector<unsigned int>		slotOf;		// slot of the entity in this row
+
+	// per slot
+	std::vector<u32>						generation;	// bumped every time the slot is freed
+	std::vector<unsigned int>		rowOf;		// row of the entity in this slot, ENTITY_ROW_NONE when free
+	std::vector<unsigned int>		freeSlots;	// stack of free slot indices, next to use on top
+};
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// sizes every array to capacity and marks every slot free
+void EntityStoreInit(EntityStore& store, unsigned int capacity);
+
+// frees every slot, every handle issued so far becomes stale
+void EntityStoreClear(EntityStore& store);
+
+// takes a free slot and the row after the last live one in constant time,
+// returns ENTITY_INVALID when the store is full. the new entity never wraps
+EntityHandle EntityCreate(EntityStore& store, unsigned long type, float scale,
+													const AEVec2* pPos, const AEVec2* pVel, float dir);
+
+// overwrites a live entity in place, the handle stays the same
+void EntitySet(EntityStore& store, EntityHandle handle, unsigned long type, float scale,
+							 const AEVec2* pPos, const AEVec2* pVel, float dir);
+
+// frees the slot of a live entity, destroying through a stale handle does nothing.
+// the last row is moved into the freed row, so a pass that destroys while
+// walking the rows should walk them backwards
+void EntityDestroy(EntityStore& store, EntityHandle handle);
+
+// true when the handle still names the entity it was issued for
+bool EntityIsAlive(const EntityStore& store, EntityHandle handle);
+
+// handle of the entity living in a row
+EntityHandle EntityHandleOfRow(const EntityStore& store, unsigned int row);
+
+// slot of a handle, stays the same for the whole life of the entity
+inline unsigned int EntityIndex(EntityHandle handle)
+{
+	return handle & ENTITY_INDEX_MASK;
+}
+
+// current row of a live handle
+inline unsigned int EntityRow(const EntityStore& store, EntityHandle handle)
+{
+	return store.rowOf[EntityIndex(handle)];
+}
+
+#endif // ASS4_ENTITY_STORE_H_
@@ -18,7 +18,7 @@ prior written consent of DigiPen Institute of Technology is prohibited.
 
 // ---------------------------------------------------------------------------
 
-#include "AEEngine.h"
+#include "Platform.h"
 
 // ---------------------------------------------------------------------------
 // include the list of game states
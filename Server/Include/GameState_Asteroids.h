@@ -16,49 +16,21 @@ prior written consent of DigiPen Institute of Technology is prohibited.
 #ifndef ASS4_GAME_STATE_PLAY_H_
 #define ASS4_GAME_STATE_PLAY_H_
 
-#include "main.h"
+#include "Main.h"
 #include <iostream>
 #include <cstdlib>
 #include <vector>
 #include <ctime>
 #include "Collision.h"
-
-/******************************************************************************/
-/*!
-	Struct/Class Definitions
-*/
-/******************************************************************************/
-
-//Game object structure
-struct GameObj
-{
-	unsigned long		type;		// object type
-	AEGfxVertexList* pMesh;		// This will hold the triangles which will form the shape of the object
-};
-
-//Game object instance structure
-struct GameObjInst
-{
-	GameObj* pObject;	// pointer to the 'original' shape
-	unsigned long		flag;		// bit flag or-ed together
-	float				scale;		// scaling value of the object instance
-	AEVec2				posCurr;	// object current position
-	AEVec2				velCurr;	// object current velocity
-	float				dirCurr;	// object current direction
-	AABB				boundingBox;// object bouding box that encapsulates the object
-	AEMtx33				transform;	// object transformation matrix: Each frame, 
-	int					fromShipIdx;
-	// calculate the object instance's transformation matrix and save it here
-};
+#include "EntityStore.h"
+#include "InputBuffer.h"
 
 /******************************************************************************/
 /*!
 	Defines
 */
 /******************************************************************************/
-const unsigned int	GAME_OBJ_NUM_MAX = 32;					// The total number of different objects (Shapes)
 const unsigned int	GAME_OBJ_INST_NUM_MAX = 2048;		// The total number of different game object instances
-const unsigned long FLAG_ACTIVE = 0x00000001;
 
 const unsigned int	SHIP_INITIAL_NUM = 3;						// initial number of ship lives
 const float					SHIP_SIZE = 16.0f;							// ship size
@@ -73,21 +45,20 @@ const float					ASTEROID_SIZE = 70.f;
 const float					ASTEROID_SPEED = 50.f;
 
 const float					BOUNDING_RECT_SIZE = 1.0f;      // this is the normalized bounding rectangle (width and height) sizes - AABB collision data
-extern double				PACKAGE_INTERVAL;					  // How often (secs) will the server send packages to all the clients 
 
-enum MESSAGE_TYPE
+enum TYPE
 {
-	// list of possible message types
-	TYPE_MOVEMENT_UP,
-	TYPE_MOVEMENT_DOWN,
-	TYPE_MOVEMENT_LEFT,
-	TYPE_MOVEMENT_RIGHT,
-	TYPE_SHOOT
+	// list of game object types
+	TYPE_SHIP = 0, 
+	TYPE_BULLET,
+	TYPE_ASTEROID,
+
+	TYPE_NUM
 };
 
 struct SHIP_OBJ
 {
-	int objectID;
+	EntityHandle objectID;
 	int shipLive;
 	int score;
 	bool isDead;
@@ -122,10 +93,18 @@ struct OTHER_OBJ_INFO
 
 
 
+int constexpr INPUT_REDUNDANCY{ 4 };		// ticks of keys every input datagram carries
+
+// the keys a player holds, sent once per client tick. the ticks before it are
+// repeated so one that was lost still arrives with the next datagrams. read
+// from an input packet, see Protocol.h
 struct CLIENT_MESSAGE_FORMAT
 {
+	int RoomID;
 	int ShipID;
-	int MessageType;
+	int Tick;													// client tick of Keys[0]
+	unsigned int Ack;									// newest snapshot the client has, SNAPSHOT_NONE for none
+	unsigned char Keys[INPUT_REDUNDANCY];			// INPUT_KEY bits held in Tick, Tick - 1, ...
 };
 
 // ---------------------------------------------------------------------------
@@ -136,10 +115,31 @@ void GameStateAsteroidsUpdate(void);
 void GameStateAsteroidsDraw(void);
 void GameStateAsteroidsFree(void);
 void GameStateAsteroidsUnload(void);
-int AddNewShip();
-int FireBullet(int shipid, AEVec2& pos, AEVec2& vel);
-void gameObjInstSet(int id, unsigned long type, float scale, AEVec2* pPos, AEVec2* pVel, float dir);
-extern GameObjInst sGameObjInstList[GAME_OBJ_INST_NUM_MAX];
+
+struct Room;
+EntityHandle AddNewShip(Room& room);
+EntityHandle FireBullet(Room& room, EntityHandle ship, AEVec2& pos, AEVec2& vel);
+
+// applies the keys a player held during one tick to its ship, called by the
+// room's tick
+void ApplyShipInput(Room& room, EntityHandle ship, InputKeys keys);
+
+// room and ship of the player at address, a new player gets a ship in the
+// shard's first room with space, or a new room sending on socket. nullptr
+// when every room of the shard is taken
+Room* JoinRoom(unsigned int shard, SOCKET socket, const sockaddr_in& address, EntityHandle& ship);
+
+// buffers the input of a player until the tick it was meant for. dropped
+// unless from is the address of the player whose ship the message names
+void RoomQueueInput(Room& room, const sockaddr_in& from, const CLIENT_MESSAGE_FORMAT& message);
+
+// simulates one fixed length tick of a room, taking one input of every player.
+// snapshot also quantizes the room at the end of the tick for RoomSendSnapshot
+void RoomStep(Room& room, f32 dt, bool snapshot);
+
+// sends the snapshot the last RoomStep with snapshot set made to the room's
+// players, returns how many got it and adds the bytes sent to bytes
+unsigned int RoomSendSnapshot(Room& room, u64& bytes);
 
 
 // ---------------------------------------------------------------------------
@@ -0,0 +1,83 @@
+/******************************************************************************/
+/*!
+\file			InputBuffer.h
+\author
+\par
+\date
+\brief		This is the input buffer header file. Clients number their inputs
+					with their own tick, the server keeps a few ticks of them per
+					player and takes exactly one every simulation tick, so a ship
+					moves the same however many datagrams its player sends and
+					however unevenly they arrive.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_INPUT_BUFFER_H_
+#define ASS4_INPUT_BUFFER_H_
+
+#include "Platform.h"
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+const unsigned int	INPUT_BUFFER_SIZE = 64;					// ticks of one player kept at once, a power of 2
+const unsigned int	INPUT_BUFFER_DEPTH_DEFAULT = 2;	// ticks held back to ride out jitter
+const unsigned int	INPUT_BUFFER_DEPTH_MAX = INPUT_BUFFER_SIZE / 4;
+const unsigned int	INPUT_BUFFER_REPEAT_MAX = 4;		// ticks without input that still keep the keys held
+
+// keys held by a player during one tick
+typedef u8 InputKeys;
+
+enum INPUT_KEY
+{
+	INPUT_KEY_UP		= 1 << 0,
+	INPUT_KEY_DOWN	= 1 << 1,
+	INPUT_KEY_LEFT	= 1 << 2,
+	INPUT_KEY_RIGHT	= 1 << 3,
+	INPUT_KEY_SHOOT	= 1 << 4,		// pressed this tick, never repeated
+};
+
+struct InputBuffer
+{
+	u32					ticks[INPUT_BUFFER_SIZE];		// client tick held by each entry
+	InputKeys		keys[INPUT_BUFFER_SIZE];
+	unsigned int	depth;
+	bool				receiving;		// some input arrived since the last restart
+	bool				started;			// depth ticks were buffered, one is taken every tick
+	u32					next;					// client tick the next simulation tick takes
+	u32					newest;				// highest client tick received
+	InputKeys		last;					// keys of the last tick that arrived
+	unsigned int	repeated;		// ticks in a row that reused them
+	unsigned int	lateStreak;	// datagrams in a row that came after their tick was taken
+
+	// counters, they only ever go up
+	u32					late;					// arrived after their tick was taken
+	u32					missed;				// ticks taken before their input arrived, even redundantly
+	u32					skipped;			// ticks thrown away when the client ran ahead
+};
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// empties the buffer, it holds back depth ticks before the first one is taken
+void InputBufferInit(InputBuffer& buffer, unsigned int depth);
+
+// stores the keys of count ticks, newest first from tick down. the ticks that
+// are already buffered or taken are left alone, so the copies a datagram
+// carries of earlier ticks only fill the gaps. false when tick itself was
+// already taken, unless depth datagrams in a row were, or it is far behind:
+// the buffer then starts over from tick
+bool InputBufferAdd(InputBuffer& buffer, u32 tick, const InputKeys* keys, unsigned int count);
+
+// keys for the tick being simulated, call it exactly once per tick. a tick
+// that never arrived repeats the keys held before it without the shot, for
+// at most INPUT_BUFFER_REPEAT_MAX ticks
+InputKeys InputBufferTake(InputBuffer& buffer);
+
+#endif // ASS4_INPUT_BUFFER_H_
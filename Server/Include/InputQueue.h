@@ -0,0 +1,79 @@
+/******************************************************************************/
+/*!
+\file			InputQueue.h
+\author
+\par
+\date
+\brief		This is the input queue header file. A bounded ring of decoded
+					client datagrams that any thread may push to without a lock and
+					one thread, the shard that owns the rooms, pops from at the
+					start of its ticks.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_INPUT_QUEUE_H_
+#define ASS4_INPUT_QUEUE_H_
+
+#include "GameState_Asteroids.h"
+#include <atomic>
+#include <memory>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+const unsigned int	INPUT_QUEUE_CAPACITY = 4096;		// commands one shard can have waiting, a power of 2
+const unsigned int	INPUT_QUEUE_PAD = 64;					// keeps the producer and consumer ends on their own cache lines
+
+enum INPUT_COMMAND
+{
+	INPUT_COMMAND_INPUT,
+	INPUT_COMMAND_JOIN,
+	INPUT_COMMAND_LEAVE,		// from a shard that closed the room of the player at from
+};
+
+// a datagram once it is known what it is
+struct InputCommand
+{
+	sockaddr_in						from;
+	INPUT_COMMAND					type;
+	CLIENT_MESSAGE_FORMAT	message;			// only for inputs
+};
+
+// sequence says whose turn the cell is: position for the producer that
+// claims it, position + 1 once it holds a command for the consumer
+struct InputQueueCell
+{
+	std::atomic<u32>	sequence;
+	InputCommand			command;
+};
+
+struct InputQueue
+{
+	std::unique_ptr<InputQueueCell[]>	cells;
+	u32																mask;
+	char															pad0[INPUT_QUEUE_PAD];
+	std::atomic<u32>									head;			// next position to claim, shared by the producers
+	char															pad1[INPUT_QUEUE_PAD];
+	u32																tail;			// next position to pop, only the consumer touches it
+	std::atomic<u64>									dropped;	// pushes that found the ring full
+};
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// empties the queue and sizes it to capacity, rounded up to a power of 2
+void InputQueueInit(InputQueue& queue, unsigned int capacity);
+
+// false, and the command is dropped, when the ring is full. any thread
+bool InputQueuePush(InputQueue& queue, const InputCommand& command);
+
+// false when nothing is waiting. only the owning thread
+bool InputQueuePop(InputQueue& queue, InputCommand& command);
+
+#endif // ASS4_INPUT_QUEUE_H_
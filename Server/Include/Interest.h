@@ -0,0 +1,82 @@
+/******************************************************************************/
+/*!
+\file			Interest.h
+\author
+\par
+\date
+\brief		This is the interest management header file. A player is only
+					sent the objects within a radius or a view rectangle around its
+					ship. The objects of a room are bucketed once per snapshot in a
+					grid every player then queries, so the work per player follows
+					what it sees rather than the size of the world. Like everything
+					else the area wraps over the world edges, each object past its
+					own wrap margin like the simulation moves it.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_INTEREST_H_
+#define ASS4_INTEREST_H_
+
+#include "Platform.h"
+#include "SimKernel.h"
+#include <vector>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+const f32						INTEREST_HYSTERESIS = 1.1f;		// an object seen leaves past this much of the area
+
+// area around a player's ship, a radius when it is set, else a view
+// rectangle, else the whole world
+struct InterestConfig
+{
+	f32		radius;
+	f32		halfWidth, halfHeight;
+};
+
+// objects of one room bucketed by position, the caller fills posX, posY,
+// margins and slots, one entry per object by ascending slot, before building it
+struct InterestGrid
+{
+	std::vector<f32>					posX, posY;
+	std::vector<f32>					margins;			// wrap margin, an object comes around every bounds plus twice it
+	std::vector<u32>					slots;
+	std::vector<unsigned int>	cellStart;		// first entry of every cell in items, then the item count
+	std::vector<unsigned int>	items;				// object indices, by cell then ascending
+	SimBounds									bounds;
+	f32												cellSize;
+	unsigned int							columns, rows;
+};
+
+// what one player sees, and what came and went with the last update
+struct InterestSet
+{
+	std::vector<u32>	slots;			// ascending
+	std::vector<u32>	entered;
+	std::vector<u32>	left;
+};
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// false when config covers the whole world, nothing needs filtering then
+bool InterestEnabled(const InterestConfig& config);
+
+// buckets posX and posY in cells of cellSize over bounds, objects outside
+// the bounds go in the nearest edge cell
+void InterestGridBuild(InterestGrid& grid, const SimBounds& bounds, f32 cellSize);
+
+// indices of the objects of the grid in the area around x, y, ascending,
+// config has to be enabled. the ones already in set stay until they are past INTEREST_HYSTERESIS of
+// the area. set then holds their slots, with the ones that entered and left
+// since the last update
+void InterestUpdate(InterestSet& set, const InterestGrid& grid, const InterestConfig& config,
+	f32 x, f32 y, std::vector<unsigned int>& found);
+
+#endif // ASS4_INTEREST_H_
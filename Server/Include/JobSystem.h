@@ -0,0 +1,90 @@
+/******************************************************************************/
+/*!
+\file			JobSystem.h
+\author
+\par
+\date
+\brief		This is the job system header file. A fixed set of worker
+					threads, each with its own queue of jobs, that steal from each
+					other's queues once their own runs dry. Work is handed over as a
+					graph of jobs, a job only starts once every job it depends on is
+					finished, or as a parallel for over a range of numbers. The
+					thread that runs a graph works on it too, so with no workers
+					everything simply runs on that thread in dependency order.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_JOB_SYSTEM_H_
+#define ASS4_JOB_SYSTEM_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <vector>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+const unsigned int	JOB_WORKER_COUNT_DEFAULT = 3;		// threads besides the game loop when nothing else is asked for
+const unsigned int	JOB_WORKER_COUNT_MAX = 64;		// most threads besides the game loop
+
+typedef std::function<void()>												JobFunction;
+typedef std::function<void(unsigned int, unsigned int)>	JobRangeFunction;		// begin, end
+
+struct JobGraph;
+
+struct Job
+{
+	JobFunction								function;
+	JobGraph*									graph;
+	std::vector<Job*>					next;							// jobs that depend on this one
+	unsigned int							dependencyCount;	// jobs this one depends on
+	std::atomic<unsigned int>	waitingOn;				// of those, the ones not finished yet
+};
+
+// built once and run as often as needed, the jobs stay where they are while
+// more are added
+struct JobGraph
+{
+	std::deque<Job>						jobs;
+	std::atomic<unsigned int>	unfinished;
+};
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// starts workerCount threads besides the caller, cut to JOB_WORKER_COUNT_MAX,
+// 0 runs every job on the caller
+void JobSystemInit(unsigned int workerCount);
+
+// stops and joins the threads, nothing may be running
+void JobSystemExit();
+
+// threads besides the caller
+unsigned int JobSystemGetWorkerCount();
+
+// adds a job to the graph, it runs after every job it is made to depend on
+Job* JobGraphAdd(JobGraph& graph, JobFunction function);
+
+// job does not start before before is finished, both in the same graph
+void JobGraphDepend(Job* job, Job* before);
+
+// removes every job
+void JobGraphClear(JobGraph& graph);
+
+// runs every job of the graph and returns once they are all finished, the
+// caller runs jobs meanwhile. a job may run a graph or a parallel for of its own
+void JobGraphRun(JobGraph& graph);
+
+// calls function on [begin, end) ranges of at most grain numbers that
+// together cover [0, count), spread over the workers and the caller, and
+// returns once they are all done
+void JobParallelFor(unsigned int count, unsigned int grain, const JobRangeFunction& function);
+
+#endif // ASS4_JOB_SYSTEM_H_
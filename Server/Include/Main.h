@@ -17,22 +17,22 @@ prior written consent of DigiPen Institute of Technology is prohibited.
 #ifndef ASS4_MAIN_H_
 #define ASS4_MAIN_H_
 
-#ifndef WIN32_LEAN_AND_MEAN
-#define WIN32_LEAN_AND_MEAN
-#endif
-
 // ---------------------------------------------------------------------------
 // includes
 
-#include "AEEngine.h"
-#include "Math.h"
+#include "Platform.h"
+#include <cmath>
 
 #include "GameStateMgr.h"
 #include "GameState_Asteroids.h"
 #include "Collision.h"
-
-#include "ws2tcpip.h"
-#pragma comment(lib, "ws2_32.lib")
+#include "SimClock.h"
+#include "SimKernel.h"
+#include "Broadphase.h"
+#include "JobSystem.h"
+#include "InputBuffer.h"
+#include "Protocol.h"
+#include "Interest.h"
 
 #include <string>
 #include <iostream>
@@ -40,10 +40,14 @@ prior written consent of DigiPen Institute of Technology is prohibited.
 #include <thread>
 #include <vector>
 #include <mutex>
+#include <atomic>
 
+// sent in a join reply, see Protocol.h
 struct SERVER_INITIAL_MESSAGE_FORMAT
 {
 	int ShipID;
+	int RoomID;
+	int TickRate;		// the client numbers its inputs with ticks of this rate
 };
 
 //------------------------------------
@@ -51,15 +55,29 @@ struct SERVER_INITIAL_MESSAGE_FORMAT
 
 extern float	g_dt;
 extern double	g_appTime;
-extern SOCKET listenerSocket;
-extern int constexpr MAX_CLIENTS{ 1 };
-extern std::mutex GAME_OBJECT_LIST_MUTEX;
-extern std::vector<sockaddr_in> ClientSocket;
+extern std::string g_serverPort;
+extern unsigned int g_tickRate;
+extern unsigned int g_randomSeed;
+extern SIM_KERNEL_ISA g_simKernelIsa;
+extern BROADPHASE_TYPE g_broadphase;
+extern unsigned int g_workerCount;
+extern unsigned int g_shardCount;
+extern unsigned int g_inputDelay;
+extern QuantizeConfig g_quantize;		// bits come from the arguments, the rest from the game
+extern unsigned int g_deltaTolerance;		// position steps an object may drift from its predicted place
+extern unsigned int g_snapshotBudget;		// bytes of one snapshot to one player, removals and changes past it wait
+extern InterestConfig g_interest;				// area around a ship whose objects its player is sent
+extern unsigned int g_roomPlayers;			// players a room takes before the next one opens
+int constexpr MAX_CLIENTS{ 8 };				// most players per room
 
 // ---------------------------------------------------------------------------
 // functions
 
+struct Room;
+
 int WinsockServerSetup();
+bool ParseServerArgs(int argc, char* argv[]);
+int RunServer();
 
 #endif
 
@@ -0,0 +1,34 @@
+/******************************************************************************/
+/*!
+\file			Narrowphase.h
+\author
+\par
+\date
+\brief		This is the collision narrowphase header file. It is the
+					detection stage of a room's tick: the pairs the broadphase found
+					go through CollisionIntersection_RectRectBatch and every hit is
+					recorded as an event for the resolution stage to apply.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_NARROWPHASE_H_
+#define ASS4_NARROWPHASE_H_
+
+#include "Platform.h"
+
+struct Room;
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// tests the room's pairScratch, sorted by query as BroadphaseFindPairs leaves
+// them, over dt and fills its eventScratch with the hits. nothing in the
+// world changes, and the events come out the same, in the same order, for
+// any number of job workers
+void DetectCollisions(Room& room, f32 dt);
+
+#endif // ASS4_NARROWPHASE_H_
@@ -0,0 +1,165 @@
+/******************************************************************************/
+/*!
+\file			Platform.h
+\author
+\par
+\date
+\brief		This is the platform layer of the server. It hides the few Alpha
+					Engine and Winsock calls the simulation needs (window bounds,
+					frame time, wrap, sockets) so that the server can be built
+					headless by defining SERVER_HEADLESS, without AESysInit, a
+					window or a graphics stack.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_PLATFORM_H_
+#define ASS4_PLATFORM_H_
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+// ---------------------------------------------------------------------------
+// engine
+
+#ifndef SERVER_HEADLESS
+
+#include "AEEngine.h"
+
+#else
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// stand-ins for the Alpha Engine types and macros used by the simulation
+typedef char								s8;
+typedef unsigned char				u8;
+typedef signed short				s16;
+typedef unsigned short			u16;
+typedef signed int					s32;
+typedef unsigned int				u32;
+typedef signed long long		s64;
+typedef unsigned long long	u64;
+typedef float								f32;
+typedef double							f64;
+
+struct AEVec2
+{
+	f32 x, y;
+};
+
+#ifndef PI
+#define	PI		3.1415926f
+#endif
+
+#ifndef UNREFERENCED_PARAMETER
+#define UNREFERENCED_PARAMETER(P) (void)(P)
+#endif
+
+#define AE_ASSERT(x)														\
+{																			\
+	if((x) == 0)															\
+	{																		\
+		fprintf(stderr, "AE_ASSERT: %s\nLine: %d\nFunc: %s\nFile: %s\n",	\
+			#x, __LINE__, __FUNCTION__, __FILE__);							\
+		exit(1);															\
+	}																		\
+}
+
+#define AE_ASSERT_MESG(x, ...)												\
+{																			\
+	if((x) == 0)															\
+	{																		\
+		fprintf(stderr, "AE_ASSERT_MESG: %s\nLine: %d\nFunc: %s\nFile: %s\n",\
+			#x, __LINE__, __FUNCTION__, __FILE__);							\
+		fprintf(stderr, "Mesg: ");											\
+		fprintf(stderr, __VA_ARGS__);										\
+		fprintf(stderr, "\n");												\
+		exit(1);															\
+	}																		\
+}
+
+#define AE_FATAL_ERROR(...)												\
+{																		\
+	fprintf(stderr, "AE_FATAL_ERROR: ");								\
+	fprintf(stderr, __VA_ARGS__);										\
+	exit(1);															\
+}
+
+#endif // SERVER_HEADLESS
+
+// ---------------------------------------------------------------------------
+// sockets
+
+#ifdef _WIN32
+
+#include "ws2tcpip.h"
+#pragma comment(lib, "ws2_32.lib")
+
+#define SOCKET_SHUTDOWN_BOTH SD_BOTH
+
+#else
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <cerrno>
+
+typedef int SOCKET;
+
+#define INVALID_SOCKET				(-1)
+#define SOCKET_ERROR					(-1)
+#define NO_ERROR							0
+#define SOCKET_SHUTDOWN_BOTH	SHUT_RDWR
+
+#define closesocket						close
+#define WSAGetLastError()			errno
+#define SecureZeroMemory(p, n)	memset((p), 0, (n))
+
+#endif // _WIN32
+
+// ---------------------------------------------------------------------------
+// functions
+
+// call once before the game state manager starts, after AESysInit when windowed
+void PlatformInit(unsigned int winWidth, unsigned int winHeight, unsigned int frameRate);
+
+// frame boundaries of the server loop (AESysFrameStart/End when windowed)
+void PlatformFrameStart();
+void PlatformFrameEnd();
+
+// true when the window was closed, escape was pressed or the process was signalled
+bool PlatformQuitRequested();
+
+// world bounds, same values as AEGfxGetWinMin/Max when windowed
+f32 PlatformGetWinMinX();
+f32 PlatformGetWinMaxX();
+f32 PlatformGetWinMinY();
+f32 PlatformGetWinMaxY();
+
+// duration of the last frame in seconds
+f64 PlatformGetFrameTime();
+
+// wraparound for x with respect to range (x0 to x1), same rules as AEWrap
+f32 PlatformWrap(f32 x, f32 x0, f32 x1);
+
+// WSAStartup/WSACleanup on windows, nothing elsewhere
+int  PlatformNetInit();
+void PlatformNetExit();
+
+// true once socket has a datagram waiting, false when seconds ran out first
+bool PlatformNetWait(SOCKET socket, f64 seconds);
+
+// keeps the calling thread on one core, core is taken modulo the core count
+void PlatformPinThread(unsigned int core);
+
+#endif // ASS4_PLATFORM_H_
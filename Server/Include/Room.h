@@ -0,0 +1,177 @@
+/******************************************************************************/
+/*!
+\file			Room.h
+\author
+\par
+\date
+\brief		This is the room header file. A room is one match: its own world,
+					ship table and players. The server hosts many of them at once,
+					every datagram names the room it belongs to and the rooms are
+					looked up from that id. Every room belongs to one shard and is
+					only ever touched by that shard's thread, the shard is the low
+					byte of the id. A room whose players all went quiet is closed
+					and its index handed to the next room the shard opens.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_ROOM_H_
+#define ASS4_ROOM_H_
+
+#include "GameState_Asteroids.h"
+#include "EntityStore.h"
+#include "Broadphase.h"
+#include "JobSystem.h"
+#include "InputBuffer.h"
+#include "Protocol.h"
+#include "Interest.h"
+#include <random>
+#include <vector>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+typedef u32 RoomID;
+
+const RoomID				ROOM_INVALID = 0xFFFFFFFF;
+const unsigned int	ROOM_SHARD_BITS = 8;					// low bits of an id, the shard that owns the room
+const unsigned int	ROOM_INDEX_BITS = 10;					// next ones, its place among the shard's rooms
+const unsigned int	ROOM_NUM_MAX = 1u << ROOM_INDEX_BITS;		// matches one shard hosts at most
+const f64						ROOM_IDLE_TIMEOUT = 10.0;			// seconds without a datagram from any player before a room closes
+
+// the bits above the index count how often it was reused, so a late datagram
+// for a closed room never lands in the one that took its place. one short
+// of the rest, an id has to survive being sent as an int
+const unsigned int	ROOM_GENERATION_BITS = 31 - ROOM_SHARD_BITS - ROOM_INDEX_BITS;
+
+// shard that owns the room
+inline unsigned int RoomShard(RoomID id)
+{
+	return id & ((1u << ROOM_SHARD_BITS) - 1);
+}
+
+// its place among the rooms of the shard
+inline unsigned int RoomIndex(RoomID id)
+{
+	return (id >> ROOM_SHARD_BITS) & (ROOM_NUM_MAX - 1);
+}
+
+// an asteroid touched a ship or a bullet, both are rows of the entity store
+struct CollisionEvent
+{
+	unsigned int asteroid;
+	unsigned int target;
+};
+
+// candidates of one asteroid, packed for CollisionIntersection_RectRectBatch
+struct CollisionBatch
+{
+	std::vector<float>					minX, minY, maxX, maxY, velX, velY;
+	std::vector<unsigned char>	hits;
+
+	void Resize(size_t count)
+	{
+		minX.resize(count); minY.resize(count); maxX.resize(count); maxY.resize(count);
+		velX.resize(count); velY.resize(count); hits.resize(count);
+	}
+};
+
+// what one detection task works on and finds, a task only ever touches its own
+struct DetectTask
+{
+	CollisionBatch								batch;
+	std::vector<CollisionEvent>		events;
+};
+
+struct Room
+{
+	RoomID												id;
+	SOCKET												socket;						// of the owning shard, snapshots go out on it
+
+	EntityStore										store;						// every game object instance, one array per field
+	std::vector<SHIP_OBJ>					ships;						// one per player, in joining order
+	std::vector<sockaddr_in>			clients;					// address of every player, same order as ships
+	std::vector<InputBuffer>			inputs;						// inputs of every player waiting for their tick, same order
+	std::vector<SnapshotHistory>	snapshots;				// sent to every player, same order
+	std::vector<std::vector<f32>>	priorities;				// of every slot for every player, same order
+	std::vector<InterestSet>			interests;				// objects every player is sent, same order
+	std::vector<u32>							heard;						// tick every player last sent something valid, same order
+	std::mt19937									random;						// every random number the room uses comes from here
+	BroadphaseContext*						broadphase;
+	u32														snapshotSequence;	// of the next snapshot sent
+
+	// the phases of one tick, built once and run every tick with these
+	JobGraph											tickGraph;
+	f32														stepDt;
+	SimBounds											stepBounds;
+	bool													stepSnapshot;			// the tick ends with the serialize phase
+
+	// rebuilt every tick
+	std::vector<unsigned int>			asteroidScratch;	// rows of the live asteroids
+	std::vector<unsigned int>			targetScratch;		// rows of the ships and bullets they can hit
+	std::vector<BroadphasePair>		pairScratch;
+	std::vector<EntityHandle>			cullScratch;			// bullets removed once collisions are done
+	std::vector<unsigned int>			groupScratch;			// first pair of every asteroid, then the pair count
+	std::vector<DetectTask>				detectTasks;
+	std::vector<CollisionEvent>		eventScratch;			// hits found by detection, applied in one go by resolution
+	std::vector<unsigned char>		resolvedScratch;	// per row, 1 once it took its hit this tick
+	std::vector<unsigned int>			objectScratch;		// rows of every bullet and asteroid
+	std::vector<SHIP_OBJ_INFO>		shipScratch;			// every ship as the snapshot sends it
+	std::vector<EntityState>			shipStateScratch;	// and quantized
+	unsigned int									shipBits;					// all of them take in the first fragment
+	std::vector<EntityState>			snapshotScratch;	// every object quantized, by slot
+	InterestGrid									interestGrid;			// of the same objects
+	std::vector<unsigned int>			interestScratch;	// indices of the ones one player sees
+	std::vector<EntityState>			relevantScratch;	// and the objects themselves
+	std::vector<u32>							removedScratch;		// of one player's snapshot
+	std::vector<SnapshotChange>		changeScratch;
+	std::vector<SnapshotFragment>	fragmentScratch;
+	std::vector<u8>								packetScratch;		// one fragment
+};
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// makes room for the rooms of shardCount shards, none open yet
+void RoomsInit(unsigned int shardCount);
+
+// removes every room and forgets every player
+void RoomDestroyAll();
+
+// the functions below only touch the rooms of one shard, and only that
+// shard's thread may call them for it
+
+// a new empty room with its store sized, in the lowest index a closed room
+// left. nullptr once ROOM_NUM_MAX are open
+Room* RoomCreate(unsigned int shard, SOCKET socket);
+
+// forgets the room and its players, its id is never found again
+void RoomDestroy(Room& room);
+
+// nullptr for an id that is not open
+Room* RoomFind(RoomID id);
+
+// room of the shard the address joined, nullptr when it never did. client
+// is its entry in the room's clients and ships
+Room* RoomFindClient(unsigned int shard, const sockaddr_in& address, unsigned int* client);
+
+// first open room of the shard with fewer than g_roomPlayers players, nullptr
+// when all are full
+Room* RoomFindOpen(unsigned int shard);
+
+// adds the address, an empty input buffer, snapshot history, priorities,
+// interest set and the current tick as last heard to the room's players, the
+// caller adds its ship
+void RoomAddClient(Room& room, const sockaddr_in& address);
+
+// rooms of a shard are RoomGet(shard, 0) to RoomGet(shard, RoomGetCount(shard) - 1),
+// nullptr for an index no room holds now
+unsigned int RoomGetCount(unsigned int shard);
+Room* RoomGet(unsigned int shard, unsigned int index);
+
+#endif // ASS4_ROOM_H_
@@ -0,0 +1,72 @@
+/******************************************************************************/
+/*!
+\file			Shard.h
+\author
+\par
+\date
+\brief		This is the shard header file. A shard is one thread kept on one
+					core with its own UDP socket, its own clock and its own rooms: it
+					receives the datagrams of its rooms, simulates them and sends
+					their snapshots without sharing anything with the other shards.
+					On Linux every shard socket is bound to the same port with
+					SO_REUSEPORT and the kernel hands each datagram to the socket of
+					the shard named in its room id. Elsewhere there is one shard.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_SHARD_H_
+#define ASS4_SHARD_H_
+
+#include "Platform.h"
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+
+// below 0xFF, the byte at PROTOCOL_ROOM_OFFSET of a join that names no room,
+// so the kernel never steers a join to a shard, see ShardAttachSteering
+const unsigned int	SHARD_NUM_MAX = 64;
+const unsigned int	SHARD_NUM_DEFAULT = 1;
+
+// load of one shard, the counters only ever go up
+struct ShardStats
+{
+	unsigned int	rooms;
+	unsigned int	players;
+	unsigned int	openSeats;			// players its rooms can still take
+	u64						ticks;
+	u64						tickMicroseconds;	// spent simulating, over every tick
+	u64						packetsIn;
+	u64						packetsOut;
+	u64						bytesOut;
+	u64						forwarded;			// datagrams that reached this shard for another one
+	u64						dropped;				// datagrams for this shard that found its input queue full
+};
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// opens the shard sockets on address, count is cut to SHARD_NUM_MAX, and to
+// 1 off linux. 0 on success
+int ShardsOpen(unsigned int count, const addrinfo* address);
+
+// starts one pinned thread per shard
+void ShardsStart();
+
+// stops and joins the threads, then closes the sockets
+void ShardsStop();
+
+unsigned int ShardGetCount();
+void ShardGetStats(unsigned int shard, ShardStats& stats);
+
+// shard a new player goes to: one with a free seat in an open room, so
+// matches fill up, otherwise the one with the fewest players
+unsigned int ShardPick();
+
+#endif // ASS4_SHARD_H_
@@ -0,0 +1,51 @@
+/******************************************************************************/
+/*!
+\file			SimClock.h
+\author
+\par
+\date
+\brief		This is the simulation clock header file. It turns the variable
+					frame time of the server loop into a whole number of fixed
+					length ticks, each with its own tick number.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_SIM_CLOCK_H_
+#define ASS4_SIM_CLOCK_H_
+
+#include "Platform.h"
+
+const unsigned int	SIM_TICK_RATE_DEFAULT = 60;		// ticks per second when nothing else is asked for
+const unsigned int	SIM_TICKS_PER_FRAME_MAX = 8;	// ticks run in one frame before the clock drops time
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// sets the tick rate for every thread, in ticks per second, and resets the
+// calling thread like SimClockReset
+void SimClockInit(unsigned int tickRate);
+
+// resets the accumulator and the tick number of the calling thread, the
+// functions below all work on the calling thread's clock
+void SimClockReset();
+
+// adds the frame time to the accumulator, returns how many ticks are due
+unsigned int SimClockAdvance(f64 frameTime);
+
+// marks one tick as simulated and moves to the next tick number
+void SimClockStep();
+
+// length of one tick in seconds
+f32 SimClockGetStep();
+
+// tick rate in ticks per second
+unsigned int SimClockGetTickRate();
+
+// number of the tick about to be (or being) simulated
+u32 SimClockGetTick();
+
+#endif // ASS4_SIM_CLOCK_H_
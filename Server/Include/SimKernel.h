@@ -0,0 +1,75 @@
+/******************************************************************************/
+/*!
+\file			SimKernel.h
+\author
+\par
+\date
+\brief		This is the simulation kernel header file. It integrates, wraps
+					and bounds every live row of the entity store in one sweep, with
+					an SSE2 or AVX2 version picked at startup and a scalar version
+					for every other cpu.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+ /******************************************************************************/
+
+#ifndef ASS4_SIM_KERNEL_H_
+#define ASS4_SIM_KERNEL_H_
+
+#include "EntityStore.h"
+
+// x86 builds get the SIMD paths, a function using AVX2 is marked with
+// SIM_KERNEL_TARGET_AVX2 and only called once SimKernelGetIsa says so
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIM_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define SIM_KERNEL_TARGET_AVX2
+#else
+#define SIM_KERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+enum SIM_KERNEL_ISA
+{
+	SIM_KERNEL_SCALAR = 0,
+	SIM_KERNEL_SSE2,				// 4 rows per instruction
+	SIM_KERNEL_AVX2,				// 8 rows per instruction
+
+	SIM_KERNEL_ISA_NUM
+};
+
+// world edges for one tick, read once instead of once per entity
+struct SimBounds
+{
+	f32 minX, maxX, minY, maxY;
+};
+
+// ---------------------------------------------------------------------------
+// Function prototypes
+
+// picks the widest instruction set the cpu supports, never wider than maxIsa
+void SimKernelInit(SIM_KERNEL_ISA maxIsa = SIM_KERNEL_AVX2);
+
+// instruction set picked by SimKernelInit, and its name for the log
+SIM_KERNEL_ISA SimKernelGetIsa();
+const char* SimKernelGetIsaName(SIM_KERNEL_ISA isa);
+
+// for rows begin to end - 1:
+//	-- the bounding box is taken around the position at the start of the tick,
+//		 halfExtent * scale on each side
+//	-- the position is integrated with the current velocity
+//	-- rows with a finite wrapMargin are wrapped (AEWrap rules) over the
+//		 bounds pushed out by their margin
+// every instruction set gives the same result bit for bit
+void SimKernelIntegrateWrap(EntityStore& store, unsigned int begin, unsigned int end,
+														f32 dt, f32 halfExtent, const SimBounds& bounds);
+
+#endif // ASS4_SIM_KERNEL_H_
@@ -0,0 +1,486 @@
+/******************************************************************************/
+/*!
+\file			Broadphase.cpp
+\author
+\par
+\date
+\brief		This is the collision broadphase source file. The grid backend
+					counting-sorts the targets into cells every tick, then each query
+					walks the cells under its swept box. A pair that shares several
+					cells is only reported from the cell holding the min corner of
+					the overlap of the two boxes. Ghosts of entities near their wrap
+					edge go in the grid like any other box, tagged with their shift.
+					The sort and sweep backend keeps last tick's order of the box
+					starts on x, so an insertion sort has almost nothing to move.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "Broadphase.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/******************************************************************************/
+/*!
+	Struct/Class Definitions
+*/
+/******************************************************************************/
+
+// box covering an entity for the whole tick
+struct SweptBox
+{
+	f32 minX, minY, maxX, maxY;
+};
+
+// an entity, or one of its ghosts moved by one wrap period
+struct BroadphaseImage
+{
+	SweptBox			box;
+	f32						offsetX, offsetY;		// shift from the real entity
+	unsigned int	index;							// entry in the target list, or row of a query
+};
+
+// at most one ghost per axis plus the one in the corner
+const unsigned int	BROADPHASE_IMAGES_MAX = 4;
+
+struct BroadphaseGrid
+{
+	f32													cellSize;
+	f32													originX, originY;		// min corner of cell (0, 0)
+	int													cellsX, cellsY;
+
+	std::vector<unsigned int>		cellStart;		// targets of cell c are items[cellStart[c]] to items[cellStart[c + 1] - 1]
+	std::vector<unsigned int>		items;				// indices into images
+	std::vector<BroadphaseImage> images;			// every target and its ghosts
+	std::vector<int>						cellRange;		// x0, y0, x1, y1 of every image
+	std::vector<unsigned int>		fill;					// next free item of every cell while building
+};
+
+// key of an image that stays the same from tick to tick: slot and kind of ghost
+struct SapImage
+{
+	BroadphaseImage	image;
+	u32							stamp;				// tick the image was last seen in
+	u32							placed;				// tick the image was last put in the order
+	bool						isQuery;
+};
+
+struct BroadphaseSap
+{
+	u32													tick;
+	std::vector<SapImage>				images;				// BROADPHASE_IMAGES_MAX per slot
+	std::vector<unsigned int>		order;				// keys sorted on box.minX, kept between ticks
+	std::vector<unsigned int>		present;			// keys seen this tick
+	std::vector<unsigned int>		active;				// keys whose box is still open on x
+};
+
+struct BroadphaseContext
+{
+	BroadphaseGrid							grid;
+	BroadphaseSap								sap;
+};
+
+/******************************************************************************/
+/*!
+	Static Variables
+*/
+/******************************************************************************/
+static BROADPHASE_TYPE	sType = BROADPHASE_GRID;
+static f32							sCellSize;
+
+/******************************************************************************/
+/*!
+	Box of a row at the start of the tick grown by its motion over dt
+*/
+/******************************************************************************/
+static inline SweptBox BroadphaseSweep(const EntityStore& e, unsigned int row, f32 dt)
+{
+	f32 dx = e.velX[row] * dt;
+	f32 dy = e.velY[row] * dt;
+
+	return SweptBox{
+		e.minX[row] + (std::min)(dx, 0.0f), e.minY[row] + (std::min)(dy, 0.0f),
+		e.maxX[row] + (std::max)(dx, 0.0f), e.maxY[row] + (std::max)(dy, 0.0f) };
+}
+
+/******************************************************************************/
+/*!
+	Fills out with the swept box of a row and of its ghosts, returns how many.
+	A ghost is made on every axis where the box sticks out of the range the
+	row wraps over, shifted by the length of that range
+*/
+/******************************************************************************/
+static unsigned int BroadphaseImages(const EntityStore& e, unsigned int row, unsigned int index,
+																		 f32 dt, const SimBounds& b, BroadphaseImage* out)
+{
+	SweptBox box = BroadphaseSweep(e, row, dt);
+	f32 margin = e.wrapMargin[row];
+
+	out[0] = BroadphaseImage{ box, 0.0f, 0.0f, index };
+
+	// rows with an infinite margin never wrap
+	if (!(margin < std::numeric_limits<f32>::infinity()))
+		return 1;
+
+	f32 loX = b.minX - margin, hiX = b.maxX + margin;
+	f32 loY = b.minY - margin, hiY = b.maxY + margin;
+
+	f32 shiftX = box.minX < loX ? hiX - loX : box.maxX > hiX ? loX - hiX : 0.0f;
+	f32 shiftY = box.minY < loY ? hiY - loY : box.maxY > hiY ? loY - hiY : 0.0f;
+
+	unsigned int count = 1;
+	if (shiftX != 0.0f)
+		out[count++] = BroadphaseImage{ { box.minX + shiftX, box.minY, box.maxX + shiftX, box.maxY }, shiftX, 0.0f, index };
+	if (shiftY != 0.0f)
+		out[count++] = BroadphaseImage{ { box.minX, box.minY + shiftY, box.maxX, box.maxY + shiftY }, 0.0f, shiftY, index };
+	if (shiftX != 0.0f && shiftY != 0.0f)
+		out[count++] = BroadphaseImage{ { box.minX + shiftX, box.minY + shiftY, box.maxX + shiftX, box.maxY + shiftY }, shiftX, shiftY, index };
+
+	return count;
+}
+
+static inline bool BroadphaseOverlap(const SweptBox& a, const SweptBox& b)
+{
+	return !(a.maxX < b.minX || a.maxY < b.minY || a.minX > b.maxX || a.minY > b.maxY);
+}
+
+/******************************************************************************/
+/*!
+	Every image of every query against every image of every target, keeps
+	the ones whose boxes overlap like the other backends do
+*/
+/******************************************************************************/
+static void BroadphaseBrute(const EntityStore& e, f32 dt, const SimBounds& bounds,
+														const std::vector<unsigned int>& queries,
+														const std::vector<unsigned int>& targets,
+														std::vector<BroadphasePair>& pairs)
+{
+	BroadphaseImage qi[BROADPHASE_IMAGES_MAX], ti[BROADPHASE_IMAGES_MAX];
+
+	for (unsigned int q : queries)
+	{
+		unsigned int qn = BroadphaseImages(e, q, q, dt, bounds, qi);
+
+		for (unsigned int t : targets)
+		{
+			unsigned int tn = BroadphaseImages(e, t, t, dt, bounds, ti);
+
+			for (unsigned int a = 0; a < qn; a++)
+				for (unsigned int b = 0; b < tn; b++)
+				{
+					if (BroadphaseOverlap(qi[a].box, ti[b].box))
+						pairs.push_back(BroadphasePair{ q, t,
+							{ qi[a].offsetX - ti[b].offsetX, qi[a].offsetY - ti[b].offsetY } });
+				}
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+	Uniform grid
+*/
+/******************************************************************************/
+
+// cells outside the grid are clamped to the border cells, so far away
+// entities are still found, only less efficiently
+static inline int GridCellX(const BroadphaseGrid& g, f32 x)
+{
+	int c = static_cast<int>(std::floor((x - g.originX) / g.cellSize));
+	return (std::max)(0, (std::min)(c, g.cellsX - 1));
+}
+
+static inline int GridCellY(const BroadphaseGrid& g, f32 y)
+{
+	int c = static_cast<int>(std::floor((y - g.originY) / g.cellSize));
+	return (std::max)(0, (std::min)(c, g.cellsY - 1));
+}
+
+static void GridBuild(BroadphaseGrid& g, const EntityStore& e, f32 dt, const SimBounds& bounds,
+											const std::vector<unsigned int>& targets)
+{
+	// one cell of border around the world holds the wrap margins and the ghosts
+	g.originX = bounds.minX - g.cellSize;
+	g.originY = bounds.minY - g.cellSize;
+	g.cellsX = static_cast<int>(std::ceil((bounds.maxX - bounds.minX) / g.cellSize)) + 2;
+	g.cellsY = static_cast<int>(std::ceil((bounds.maxY - bounds.minY) / g.cellSize)) + 2;
+
+	unsigned int cellCount = static_cast<unsigned int>(g.cellsX * g.cellsY);
+	g.cellStart.assign(cellCount + 1, 0);
+
+	// every target and its ghosts
+	g.images.resize(targets.size() * BROADPHASE_IMAGES_MAX);
+	unsigned int imageCount = 0;
+	for (unsigned int t = 0; t < targets.size(); t++)
+		imageCount += BroadphaseImages(e, targets[t], t, dt, bounds, &g.images[imageCount]);
+	g.images.resize(imageCount);
+	g.cellRange.resize(imageCount * 4);
+
+	// count the images of every cell
+	for (unsigned int m = 0; m < imageCount; m++)
+	{
+		const SweptBox& b = g.images[m].box;
+		int* r = &g.cellRange[m * 4];
+
+		r[0] = GridCellX(g, b.minX);
+		r[1] = GridCellY(g, b.minY);
+		r[2] = GridCellX(g, b.maxX);
+		r[3] = GridCellY(g, b.maxY);
+
+		for (int y = r[1]; y <= r[3]; y++)
+			for (int x = r[0]; x <= r[2]; x++)
+				g.cellStart[y * g.cellsX + x + 1]++;
+	}
+
+	// prefix sum, then drop every image in its cells
+	for (unsigned int c = 0; c < cellCount; c++)
+		g.cellStart[c + 1] += g.cellStart[c];
+
+	g.items.resize(g.cellStart[cellCount]);
+	g.fill.assign(g.cellStart.begin(), g.cellStart.end() - 1);
+
+	for (unsigned int m = 0; m < imageCount; m++)
+	{
+		const int* r = &g.cellRange[m * 4];
+
+		for (int y = r[1]; y <= r[3]; y++)
+			for (int x = r[0]; x <= r[2]; x++)
+				g.items[g.fill[y * g.cellsX + x]++] = m;
+	}
+}
+
+static void GridQuery(const BroadphaseGrid& g, const BroadphaseImage& qi,
+											const std::vector<unsigned int>& targets,
+											std::vector<BroadphasePair>& pairs)
+{
+	const SweptBox& qb = qi.box;
+	int x0 = GridCellX(g, qb.minX), y0 = GridCellY(g, qb.minY);
+	int x1 = GridCellX(g, qb.maxX), y1 = GridCellY(g, qb.maxY);
+
+	for (int y = y0; y <= y1; y++)
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			unsigned int c = static_cast<unsigned int>(y * g.cellsX + x);
+
+			for (unsigned int i = g.cellStart[c]; i < g.cellStart[c + 1]; i++)
+			{
+				const BroadphaseImage& ti = g.images[g.items[i]];
+				const SweptBox& tb = ti.box;
+
+				if (!BroadphaseOverlap(qb, tb))
+					continue;
+
+				// only the cell holding the min corner of the overlap reports the pair
+				if (GridCellX(g, (std::max)(qb.minX, tb.minX)) != x ||
+						GridCellY(g, (std::max)(qb.minY, tb.minY)) != y)
+					continue;
+
+				pairs.push_back(BroadphasePair{ qi.index, targets[ti.index],
+					{ qi.offsetX - ti.offsetX, qi.offsetY - ti.offsetY } });
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+	Sort and sweep
+*/
+/******************************************************************************/
+static void SapGather(BroadphaseSap& sap, const EntityStore& e, f32 dt, const SimBounds& bounds,
+											const std::vector<unsigned int>& rows, bool isQuery)
+{
+	BroadphaseImage images[BROADPHASE_IMAGES_MAX];
+
+	for (unsigned int row : rows)
+	{
+		unsigned int count = BroadphaseImages(e, row, row, dt, bounds, images);
+
+		for (unsigned int m = 0; m < count; m++)
+		{
+			// the kind of ghost, not its place in the list, so the key is stable
+			unsigned int kind = (images[m].offsetX != 0.0f ? 1u : 0u) | (images[m].offsetY != 0.0f ? 2u : 0u);
+			unsigned int key = e.slotOf[row] * BROADPHASE_IMAGES_MAX + kind;
+
+			SapImage& si = sap.images[key];
+			si.image = images[m];
+			si.stamp = sap.tick;
+			si.isQuery = isQuery;
+			sap.present.push_back(key);
+		}
+	}
+}
+
+static void SapFindPairs(BroadphaseSap& sap, const EntityStore& e, f32 dt, const SimBounds& bounds,
+												 const std::vector<unsigned int>& queries,
+												 const std::vector<unsigned int>& targets,
+												 std::vector<BroadphasePair>& pairs)
+{
+	sap.images.resize(e.capacity * BROADPHASE_IMAGES_MAX, SapImage{ {}, 0, 0, false });
+	sap.tick++;
+
+	sap.present.clear();
+	SapGather(sap, e, dt, bounds, queries, true);
+	SapGather(sap, e, dt, bounds, targets, false);
+
+	// keep last tick's order for what is still there, new images go at the end
+	unsigned int kept = 0;
+	for (unsigned int key : sap.order)
+	{
+		if (sap.images[key].stamp != sap.tick)
+			continue;
+		sap.images[key].placed = sap.tick;
+		sap.order[kept++] = key;
+	}
+	sap.order.resize(kept);
+
+	for (unsigned int key : sap.present)
+	{
+		if (sap.images[key].placed != sap.tick)
+		{
+			sap.images[key].placed = sap.tick;
+			sap.order.push_back(key);
+		}
+	}
+
+	// insertion sort, things barely move in one tick so this is close to linear
+	for (unsigned int i = 1; i < sap.order.size(); i++)
+	{
+		unsigned int key = sap.order[i];
+		f32 minX = sap.images[key].image.box.minX;
+
+		unsigned int j = i;
+		for (; j > 0 && sap.images[sap.order[j - 1]].image.box.minX > minX; j--)
+			sap.order[j] = sap.order[j - 1];
+		sap.order[j] = key;
+	}
+
+	// sweep on x, test y against every box still open
+	sap.active.clear();
+	for (unsigned int key : sap.order)
+	{
+		const SapImage& cur = sap.images[key];
+		const SweptBox& cb = cur.image.box;
+
+		unsigned int open = 0;
+		for (unsigned int other : sap.active)
+		{
+			const SapImage& o = sap.images[other];
+
+			// closed before this one starts, it cannot touch anything later either
+			if (o.image.box.maxX < cb.minX)
+				continue;
+			sap.active[open++] = other;
+
+			if (o.isQuery == cur.isQuery || !BroadphaseOverlap(cb, o.image.box))
+				continue;
+
+			const BroadphaseImage& qi = cur.isQuery ? cur.image : o.image;
+			const BroadphaseImage& ti = cur.isQuery ? o.image : cur.image;
+			pairs.push_back(BroadphasePair{ qi.index, ti.index,
+				{ qi.offsetX - ti.offsetX, qi.offsetY - ti.offsetY } });
+		}
+		sap.active.resize(open);
+		sap.active.push_back(key);
+	}
+}
+
+/******************************************************************************/
+/*!
+	Backend selection and the per world state
+*/
+/******************************************************************************/
+void BroadphaseInit(BROADPHASE_TYPE type, f32 cellSize)
+{
+	sType = type;
+	sCellSize = cellSize;
+}
+
+BroadphaseContext* BroadphaseCreate()
+{
+	BroadphaseContext* context = new BroadphaseContext{};
+	context->grid.cellSize = sCellSize;
+
+	return context;
+}
+
+void BroadphaseDestroy(BroadphaseContext* context)
+{
+	delete context;
+}
+
+BROADPHASE_TYPE BroadphaseGetType()
+{
+	return sType;
+}
+
+const char* BroadphaseGetTypeName(BROADPHASE_TYPE type)
+{
+	switch (type)
+	{
+	case BROADPHASE_BRUTE:	return "brute";
+	case BROADPHASE_GRID:		return "grid";
+	case BROADPHASE_SAP:		return "sap";
+	default:								return "unknown";
+	}
+}
+
+/******************************************************************************/
+/*!
+	Finds the candidate pairs with the backend picked by BroadphaseInit,
+	then sorts them and drops doubles so every backend gives the same list
+*/
+/******************************************************************************/
+void BroadphaseFindPairs(BroadphaseContext& context, const EntityStore& store, f32 dt, const SimBounds& bounds,
+												 const std::vector<unsigned int>& queries,
+												 const std::vector<unsigned int>& targets,
+												 std::vector<BroadphasePair>& pairs)
+{
+	pairs.clear();
+
+	switch (sType)
+	{
+	case BROADPHASE_GRID:
+	{
+		BroadphaseImage qi[BROADPHASE_IMAGES_MAX];
+
+		GridBuild(context.grid, store, dt, bounds, targets);
+		for (unsigned int q : queries)
+		{
+			unsigned int qn = BroadphaseImages(store, q, q, dt, bounds, qi);
+			for (unsigned int a = 0; a < qn; a++)
+				GridQuery(context.grid, qi[a], targets, pairs);
+		}
+		break;
+	}
+
+	case BROADPHASE_SAP:
+		SapFindPairs(context.sap, store, dt, bounds, queries, targets, pairs);
+		break;
+
+	default:
+		BroadphaseBrute(store, dt, bounds, queries, targets, pairs);
+		break;
+	}
+
+	std::sort(pairs.begin(), pairs.end(),
+		[](const BroadphasePair& a, const BroadphasePair& b) {
+			if (a.query != b.query)
+				return a.query < b.query;
+			if (a.target != b.target)
+				return a.target < b.target;
+			return a.offset.x != b.offset.x ? a.offset.x < b.offset.x : a.offset.y < b.offset.y;
+		});
+
+	// two ghosts shifted the same way are the same test
+	pairs.erase(std::unique(pairs.begin(), pairs.end(),
+		[](const BroadphasePair& a, const BroadphasePair& b) {
+			return a.query == b.query && a.target == b.target &&
+				a.offset.x == b.offset.x && a.offset.y == b.offset.y;
+		}), pairs.end());
+}
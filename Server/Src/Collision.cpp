@@ -6,7 +6,8 @@
 \date   	
 \brief		This is the collision source file that has the function
 					CollisionIntersection_RectRect that will check for both
-					dynamic and static collision between 2 AABBs.
+					dynamic and static collision between 2 AABBs, and a batched
+					version that checks one AABB against many without branches.
 
 Copyright (C) 2024 DigiPen Institute of Technology.
 Reproduction or disclosure of this file or its contents without the
@@ -14,7 +15,9 @@ prior written consent of DigiPen Institute of Technology is prohibited.
  */
 /******************************************************************************/
 
-#include "main.h"
+#include "Collision.h"
+#include "SimKernel.h"
+#include <algorithm>
 
 /**************************************************************************/
 /*!
@@ -22,11 +25,11 @@ prior written consent of DigiPen Institute of Technology is prohibited.
 	*/
 /**************************************************************************/
 bool CollisionIntersection_RectRect(const AABB& aabb1, const AEVec2& vel1,
-	const AABB& aabb2, const AEVec2& vel2)
+	const AABB& aabb2, const AEVec2& vel2, float dt)
 {
 	if ((aabb1.max.x < aabb2.min.x) || (aabb1.max.y < aabb2.min.y) || (aabb1.min.x > aabb2.max.x) || (aabb1.min.y > aabb2.max.y)) {
 		float timeFirst = 0;
-		float timeLast = static_cast<float>(AEFrameRateControllerGetFrameTime());
+		float timeLast = dt;
 
 		AEVec2 vb = { vel2.x - vel1.x, vel2.y - vel1.y }; //Vrel
 
@@ -38,11 +41,11 @@ bool CollisionIntersection_RectRect(const AABB& aabb1, const AEVec2& vel1,
 
 			// Case 4
 			if (aabb1.max.x < aabb2.min.x) {
-				timeFirst = max(timeFirst, (aabb1.max.x - aabb2.min.x) / vb.x);
+				timeFirst = (std::max)(timeFirst, (aabb1.max.x - aabb2.min.x) / vb.x);
 			}
 
 			if (aabb1.min.x < aabb2.max.x) {
-				timeLast = min(timeLast, (aabb1.min.x - aabb2.max.x) / vb.x);
+				timeLast = (std::min)(timeLast, (aabb1.min.x - aabb2.max.x) / vb.x);
 			}
 		}
 
@@ -54,11 +57,11 @@ bool CollisionIntersection_RectRect(const AABB& aabb1, const AEVec2& vel1,
 
 			// Case 4
 			if (aabb1.max.y < aabb2.min.y) {
-				timeFirst = max(timeFirst, (aabb1.max.y - aabb2.min.y) / vb.y);
+				timeFirst = (std::max)(timeFirst, (aabb1.max.y - aabb2.min.y) / vb.y);
 			}
 
 			if (aabb1.min.y < aabb2.max.y) {
-				timeLast = min(timeLast, (aabb1.min.y - aabb2.max.y) / vb.y);
+				timeLast = (std::min)(timeLast, (aabb1.min.y - aabb2.max.y) / vb.y);
 			}
 		}
 
@@ -70,11 +73,11 @@ bool CollisionIntersection_RectRect(const AABB& aabb1, const AEVec2& vel1,
 
 			// Case 2
 			if (aabb1.min.x > aabb2.max.x) { //The shortest distance before collision
-				timeFirst = max(timeFirst, (aabb1.min.x - aabb2.max.x) / vb.x);
+				timeFirst = (std::max)(timeFirst, (aabb1.min.x - aabb2.max.x) / vb.x);
 			}
 
 			if (aabb1.max.x > aabb2.min.x) { //The longest distance before collision
-				timeLast = min(timeLast, (aabb1.max.x - aabb2.min.x) / vb.x);
+				timeLast = (std::min)(timeLast, (aabb1.max.x - aabb2.min.x) / vb.x);
 			}
 		}
 
@@ -86,18 +89,217 @@ bool CollisionIntersection_RectRect(const AABB& aabb1, const AEVec2& vel1,
 
 			// Case 2
 			if (aabb1.min.y > aabb2.max.y) { //The shortest distance before collision
-				timeFirst = max(timeFirst, (aabb1.min.y - aabb2.max.y) / vb.y);
+				timeFirst = (std::max)(timeFirst, (aabb1.min.y - aabb2.max.y) / vb.y);
 			}
 
 			if (aabb1.max.y > aabb2.min.y) { //The longest distance before collision
-				timeLast = min(timeLast, (aabb1.max.y - aabb2.min.y) / vb.y);
+				timeLast = (std::min)(timeLast, (aabb1.max.y - aabb2.min.y) / vb.y);
 			}
 		}
 
+		// No relative motion on an axis where the boxes are apart, they never meet
+		if ((vb.x == 0) && ((aabb1.max.x < aabb2.min.x) || (aabb1.min.x > aabb2.max.x))) {
+			return false;
+		}
+
+		if ((vb.y == 0) && ((aabb1.max.y < aabb2.min.y) || (aabb1.min.y > aabb2.max.y))) {
+			return false;
+		}
+
 		// Case 5
 		if (timeFirst >= timeLast) {
 			return false;
 		}
 	}
 	return true;
-}
\ No newline at end of file
+}
+
+#ifdef SIM_KERNEL_X86
+
+/**************************************************************************/
+/*!
+	4 candidates at a time. Every case of the scalar version becomes a lane
+	mask, a time is only taken where its mask is set, the same way
+	std::max/std::min pick it, so the answer is the same lane for lane
+	*/
+/**************************************************************************/
+static inline __m128 SelectSSE2(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline void AxisSSE2(__m128 min1, __m128 max1, __m128 min2, __m128 max2, __m128 vb,
+	__m128& timeFirst, __m128& timeLast, __m128& miss)
+{
+	const __m128 zero = _mm_setzero_ps();
+	__m128 neg		= _mm_cmplt_ps(vb, zero);
+	__m128 pos		= _mm_cmpgt_ps(vb, zero);
+	__m128 still	= _mm_cmpeq_ps(vb, zero);
+	__m128 apart1	= _mm_cmpgt_ps(min1, max2);		// aabb1 past aabb2
+	__m128 apart2	= _mm_cmplt_ps(max1, min2);		// aabb1 before aabb2
+
+	// Case 1 and Case 3, moving away, and no motion while apart
+	miss = _mm_or_ps(miss, _mm_and_ps(neg, apart1));
+	miss = _mm_or_ps(miss, _mm_and_ps(pos, apart2));
+	miss = _mm_or_ps(miss, _mm_and_ps(still, _mm_or_ps(apart1, apart2)));
+
+	// Case 4 and Case 2
+	__m128 first = _mm_div_ps(SelectSSE2(neg, _mm_sub_ps(max1, min2), _mm_sub_ps(min1, max2)), vb);
+	__m128 takeFirst = _mm_or_ps(_mm_and_ps(neg, apart2), _mm_and_ps(pos, apart1));
+	takeFirst = _mm_and_ps(takeFirst, _mm_cmplt_ps(timeFirst, first));
+	timeFirst = SelectSSE2(takeFirst, first, timeFirst);
+
+	__m128 last = _mm_div_ps(SelectSSE2(neg, _mm_sub_ps(min1, max2), _mm_sub_ps(max1, min2)), vb);
+	__m128 takeLast = _mm_or_ps(_mm_and_ps(neg, _mm_cmplt_ps(min1, max2)), _mm_and_ps(pos, _mm_cmpgt_ps(max1, min2)));
+	takeLast = _mm_and_ps(takeLast, _mm_cmplt_ps(last, timeLast));
+	timeLast = SelectSSE2(takeLast, last, timeLast);
+}
+
+static unsigned int RectRectBatchSSE2(const AABB& aabb1, const AEVec2& vel1,
+	const float* minX, const float* minY, const float* maxX, const float* maxY,
+	const float* velX, const float* velY, unsigned int count, float dt,
+	unsigned char* hits, unsigned int& hitCount)
+{
+	const __m128 min1X = _mm_set1_ps(aabb1.min.x), max1X = _mm_set1_ps(aabb1.max.x);
+	const __m128 min1Y = _mm_set1_ps(aabb1.min.y), max1Y = _mm_set1_ps(aabb1.max.y);
+	const __m128 v1X = _mm_set1_ps(vel1.x), v1Y = _mm_set1_ps(vel1.y);
+	const __m128 vDt = _mm_set1_ps(dt);
+
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 min2X = _mm_loadu_ps(minX + i), max2X = _mm_loadu_ps(maxX + i);
+		__m128 min2Y = _mm_loadu_ps(minY + i), max2Y = _mm_loadu_ps(maxY + i);
+
+		__m128 apart = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(max1X, min2X), _mm_cmplt_ps(max1Y, min2Y)),
+			_mm_or_ps(_mm_cmpgt_ps(min1X, max2X), _mm_cmpgt_ps(min1Y, max2Y)));
+
+		__m128 timeFirst = _mm_setzero_ps();
+		__m128 timeLast = vDt;
+		__m128 miss = _mm_setzero_ps();
+
+		AxisSSE2(min1X, max1X, min2X, max2X, _mm_sub_ps(_mm_loadu_ps(velX + i), v1X), timeFirst, timeLast, miss);
+		AxisSSE2(min1Y, max1Y, min2Y, max2Y, _mm_sub_ps(_mm_loadu_ps(velY + i), v1Y), timeFirst, timeLast, miss);
+
+		// Case 5
+		miss = _mm_or_ps(miss, _mm_cmpge_ps(timeFirst, timeLast));
+
+		int mask = ~_mm_movemask_ps(_mm_and_ps(apart, miss));
+		for (unsigned int l = 0; l < 4; l++)
+		{
+			hits[i + l] = static_cast<unsigned char>((mask >> l) & 1);
+			hitCount += hits[i + l];
+		}
+	}
+
+	return i;
+}
+
+/**************************************************************************/
+/*!
+	8 candidates at a time
+	*/
+/**************************************************************************/
+SIM_KERNEL_TARGET_AVX2
+static inline void AxisAVX2(__m256 min1, __m256 max1, __m256 min2, __m256 max2, __m256 vb,
+	__m256& timeFirst, __m256& timeLast, __m256& miss)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	__m256 neg		= _mm256_cmp_ps(vb, zero, _CMP_LT_OQ);
+	__m256 pos		= _mm256_cmp_ps(vb, zero, _CMP_GT_OQ);
+	__m256 still	= _mm256_cmp_ps(vb, zero, _CMP_EQ_OQ);
+	__m256 apart1	= _mm256_cmp_ps(min1, max2, _CMP_GT_OQ);
+	__m256 apart2	= _mm256_cmp_ps(max1, min2, _CMP_LT_OQ);
+
+	miss = _mm256_or_ps(miss, _mm256_and_ps(neg, apart1));
+	miss = _mm256_or_ps(miss, _mm256_and_ps(pos, apart2));
+	miss = _mm256_or_ps(miss, _mm256_and_ps(still, _mm256_or_ps(apart1, apart2)));
+
+	__m256 first = _mm256_div_ps(_mm256_blendv_ps(_mm256_sub_ps(min1, max2), _mm256_sub_ps(max1, min2), neg), vb);
+	__m256 takeFirst = _mm256_or_ps(_mm256_and_ps(neg, apart2), _mm256_and_ps(pos, apart1));
+	takeFirst = _mm256_and_ps(takeFirst, _mm256_cmp_ps(timeFirst, first, _CMP_LT_OQ));
+	timeFirst = _mm256_blendv_ps(timeFirst, first, takeFirst);
+
+	__m256 last = _mm256_div_ps(_mm256_blendv_ps(_mm256_sub_ps(max1, min2), _mm256_sub_ps(min1, max2), neg), vb);
+	__m256 takeLast = _mm256_or_ps(_mm256_and_ps(neg, _mm256_cmp_ps(min1, max2, _CMP_LT_OQ)),
+		_mm256_and_ps(pos, _mm256_cmp_ps(max1, min2, _CMP_GT_OQ)));
+	takeLast = _mm256_and_ps(takeLast, _mm256_cmp_ps(last, timeLast, _CMP_LT_OQ));
+	timeLast = _mm256_blendv_ps(timeLast, last, takeLast);
+}
+
+SIM_KERNEL_TARGET_AVX2
+static unsigned int RectRectBatchAVX2(const AABB& aabb1, const AEVec2& vel1,
+	const float* minX, const float* minY, const float* maxX, const float* maxY,
+	const float* velX, const float* velY, unsigned int count, float dt,
+	unsigned char* hits, unsigned int& hitCount)
+{
+	const __m256 min1X = _mm256_set1_ps(aabb1.min.x), max1X = _mm256_set1_ps(aabb1.max.x);
+	const __m256 min1Y = _mm256_set1_ps(aabb1.min.y), max1Y = _mm256_set1_ps(aabb1.max.y);
+	const __m256 v1X = _mm256_set1_ps(vel1.x), v1Y = _mm256_set1_ps(vel1.y);
+	const __m256 vDt = _mm256_set1_ps(dt);
+
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 min2X = _mm256_loadu_ps(minX + i), max2X = _mm256_loadu_ps(maxX + i);
+		__m256 min2Y = _mm256_loadu_ps(minY + i), max2Y = _mm256_loadu_ps(maxY + i);
+
+		__m256 apart = _mm256_or_ps(
+			_mm256_or_ps(_mm256_cmp_ps(max1X, min2X, _CMP_LT_OQ), _mm256_cmp_ps(max1Y, min2Y, _CMP_LT_OQ)),
+			_mm256_or_ps(_mm256_cmp_ps(min1X, max2X, _CMP_GT_OQ), _mm256_cmp_ps(min1Y, max2Y, _CMP_GT_OQ)));
+
+		__m256 timeFirst = _mm256_setzero_ps();
+		__m256 timeLast = vDt;
+		__m256 miss = _mm256_setzero_ps();
+
+		AxisAVX2(min1X, max1X, min2X, max2X, _mm256_sub_ps(_mm256_loadu_ps(velX + i), v1X), timeFirst, timeLast, miss);
+		AxisAVX2(min1Y, max1Y, min2Y, max2Y, _mm256_sub_ps(_mm256_loadu_ps(velY + i), v1Y), timeFirst, timeLast, miss);
+
+		miss = _mm256_or_ps(miss, _mm256_cmp_ps(timeFirst, timeLast, _CMP_GE_OQ));
+
+		int mask = ~_mm256_movemask_ps(_mm256_and_ps(apart, miss));
+		for (unsigned int l = 0; l < 8; l++)
+		{
+			hits[i + l] = static_cast<unsigned char>((mask >> l) & 1);
+			hitCount += hits[i + l];
+		}
+	}
+
+	return i;
+}
+
+#endif // SIM_KERNEL_X86
+
+/**************************************************************************/
+/*!
+	Tests one box against count candidates, the widest instruction set
+	first and CollisionIntersection_RectRect for the rest
+	*/
+/**************************************************************************/
+unsigned int CollisionIntersection_RectRectBatch(const AABB& aabb1, const AEVec2& vel1,
+	const float* minX, const float* minY, const float* maxX, const float* maxY,
+	const float* velX, const float* velY, unsigned int count, float dt,
+	unsigned char* hits)
+{
+	unsigned int hitCount = 0;
+	unsigned int i = 0;
+
+#ifdef SIM_KERNEL_X86
+	if (SimKernelGetIsa() == SIM_KERNEL_AVX2)
+		i = RectRectBatchAVX2(aabb1, vel1, minX, minY, maxX, maxY, velX, velY, count, dt, hits, hitCount);
+	else if (SimKernelGetIsa() == SIM_KERNEL_SSE2)
+		i = RectRectBatchSSE2(aabb1, vel1, minX, minY, maxX, maxY, velX, velY, count, dt, hits, hitCount);
+#endif
+
+	// what is left over, or everything on the scalar path
+	for (; i < count; i++)
+	{
+		AABB		aabb2{ { minX[i], minY[i] }, { maxX[i], maxY[i] } };
+		AEVec2	vel2{ velX[i], velY[i] };
+
+		hits[i] = CollisionIntersection_RectRect(aabb1, vel1, aabb2, vel2, dt) ? 1 : 0;
+		hitCount += hits[i];
+	}
+
+	return hitCount;
+}
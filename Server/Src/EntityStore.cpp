@@ -0,0 +1,189 @@
+/******************************************************************************/
+/*!
+\file			EntityStore.cpp
+\author
+\par
+\date
+\brief		This is the entity store source file, it creates, overwrites and
+					destroys entities and keeps the live rows packed.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "EntityStore.h"
+#include <limits>
+
+/******************************************************************************/
+/*!
+	Sizes every array to capacity and marks every slot free
+*/
+/******************************************************************************/
+void EntityStoreInit(EntityStore& store, unsigned int capacity)
+{
+	AE_ASSERT(capacity <= ENTITY_INDEX_MASK);
+
+	store.capacity = capacity;
+
+	store.posX.assign(capacity, 0.0f);
+	store.posY.assign(capacity, 0.0f);
+	store.velX.assign(capacity, 0.0f);
+	store.velY.assign(capacity, 0.0f);
+	store.dir.assign(capacity, 0.0f);
+	store.scale.assign(capacity, 0.0f);
+	store.wrapMargin.assign(capacity, 0.0f);
+
+	store.minX.assign(capacity, 0.0f);
+	store.minY.assign(capacity, 0.0f);
+	store.maxX.assign(capacity, 0.0f);
+	store.maxY.assign(capacity, 0.0f);
+
+	store.type.assign(capacity, 0);
+	store.owner.assign(capacity, -1);
+	store.slotOf.assign(capacity, 0);
+
+	store.generation.assign(capacity, 0);
+	store.rowOf.assign(capacity, ENTITY_ROW_NONE);
+
+	store.count = 0;
+	EntityStoreClear(store);
+}
+
+/******************************************************************************/
+/*!
+	Frees every slot, the generations go up so old handles turn stale
+*/
+/******************************************************************************/
+void EntityStoreClear(EntityStore& store)
+{
+	for (unsigned int row = 0; row < store.count; row++)
+	{
+		unsigned int slot = store.slotOf[row];
+		store.generation[slot] = (store.generation[slot] + 1) & ENTITY_GENERATION_MASK;
+		store.rowOf[slot] = ENTITY_ROW_NONE;
+	}
+	store.count = 0;
+
+	// lowest slots on top so ids are handed out in order
+	store.freeSlots.resize(store.capacity);
+	for (unsigned int i = 0; i < store.capacity; i++)
+		store.freeSlots[i] = store.capacity - 1 - i;
+}
+
+/******************************************************************************/
+/*!
+	Takes the slot on top of the free stack and the row after the last live one
+*/
+/******************************************************************************/
+EntityHandle EntityCreate(EntityStore& store, unsigned long type, float scale,
+													const AEVec2* pPos, const AEVec2* pVel, float dir)
+{
+	// cannot find empty slot
+	if (store.freeSlots.empty())
+		return ENTITY_INVALID;
+
+	unsigned int slot = store.freeSlots.back();
+	store.freeSlots.pop_back();
+
+	unsigned int row = store.count++;
+	store.rowOf[slot] = row;
+	store.slotOf[row] = slot;
+
+	store.owner[row] = -1;
+	store.wrapMargin[row] = std::numeric_limits<float>::infinity();
+
+	EntityHandle handle = (store.generation[slot] << ENTITY_INDEX_BITS) | slot;
+	EntitySet(store, handle, type, scale, pPos, pVel, dir);
+
+	return handle;
+}
+
+/******************************************************************************/
+/*!
+	Overwrites the fields of a live entity, its slot and row stay
+*/
+/******************************************************************************/
+void EntitySet(EntityStore& store, EntityHandle handle, unsigned long type, float scale,
+							 const AEVec2* pPos, const AEVec2* pVel, float dir)
+{
+	if (!EntityIsAlive(store, handle))
+		return;
+
+	unsigned int row = EntityRow(store, handle);
+
+	store.type[row]		= static_cast<unsigned char>(type);
+	store.scale[row]	= scale;
+	store.posX[row]		= pPos ? pPos->x : 0.0f;
+	store.posY[row]		= pPos ? pPos->y : 0.0f;
+	store.velX[row]		= pVel ? pVel->x : 0.0f;
+	store.velY[row]		= pVel ? pVel->y : 0.0f;
+	store.dir[row]		= dir;
+}
+
+/******************************************************************************/
+/*!
+	Frees the slot and moves the last row into the hole
+*/
+/******************************************************************************/
+void EntityDestroy(EntityStore& store, EntityHandle handle)
+{
+	// if instance is destroyed before, just return
+	if (!EntityIsAlive(store, handle))
+		return;
+
+	unsigned int slot = EntityIndex(handle);
+	unsigned int hole = store.rowOf[slot];
+	unsigned int last = --store.count;
+
+	// move the last row into the hole to keep the rows packed
+	if (hole != last)
+	{
+		store.posX[hole]				= store.posX[last];
+		store.posY[hole]				= store.posY[last];
+		store.velX[hole]				= store.velX[last];
+		store.velY[hole]				= store.velY[last];
+		store.dir[hole]					= store.dir[last];
+		store.scale[hole]				= store.scale[last];
+		store.wrapMargin[hole]	= store.wrapMargin[last];
+
+		store.minX[hole]				= store.minX[last];
+		store.minY[hole]				= store.minY[last];
+		store.maxX[hole]				= store.maxX[last];
+		store.maxY[hole]				= store.maxY[last];
+
+		store.type[hole]				= store.type[last];
+		store.owner[hole]				= store.owner[last];
+		store.slotOf[hole]			= store.slotOf[last];
+
+		store.rowOf[store.slotOf[hole]] = hole;
+	}
+
+	// any handle still pointing at this slot is now stale
+	store.rowOf[slot] = ENTITY_ROW_NONE;
+	store.generation[slot] = (store.generation[slot] + 1) & ENTITY_GENERATION_MASK;
+	store.freeSlots.push_back(slot);
+}
+
+/******************************************************************************/
+/*!
+	Handle lookups
+*/
+/******************************************************************************/
+bool EntityIsAlive(const EntityStore& store, EntityHandle handle)
+{
+	unsigned int slot = EntityIndex(handle);
+
+	return handle != ENTITY_INVALID
+		&& slot < store.capacity
+		&& store.rowOf[slot] != ENTITY_ROW_NONE
+		&& store.generation[slot] == (handle >> ENTITY_INDEX_BITS);
+}
+
+EntityHandle EntityHandleOfRow(const EntityStore& store, unsigned int row)
+{
+	unsigned int slot = store.slotOf[row];
+
+	return (store.generation[slot] << ENTITY_INDEX_BITS) | slot;
+}
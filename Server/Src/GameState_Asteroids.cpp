@@ -14,21 +14,22 @@ prior written consent of DigiPen Institute of Technology is prohibited.
  /******************************************************************************/
 
 #include "GameState_Asteroids.h"
+#include "SimClock.h"
+#include "EntityStore.h"
+#include "SimKernel.h"
+#include "Broadphase.h"
+#include "Narrowphase.h"
+#include "JobSystem.h"
+#include "Room.h"
+#include "Shard.h"
+#include "Protocol.h"
 #include <random>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
 
-int currentAliveObjects{};
-double PACKAGE_INTERVAL;
-
-// -----------------------------------------------------------------------------
-enum TYPE
-{
-	// list of game object types
-	TYPE_SHIP = 0, 
-	TYPE_BULLET,
-	TYPE_ASTEROID,
-
-	TYPE_NUM
-};
+std::atomic<int> currentAliveObjects{};	// every shard adds to it
 
 // -----------------------------------------------------------------------------
 // object flag definition
@@ -41,27 +42,22 @@ enum TYPE
 */
 /******************************************************************************/
 
-// list of original object
-static std::vector<SHIP_OBJ> allShipInfo{};
-static std::vector<GameObjInst*> allOtherObjsInfo{};
-static GameObj				sGameObjList[GAME_OBJ_NUM_MAX];				// Each element in this array represents a unique game object (shape)
-static unsigned long		sGameObjNum;								// The number of defined game objects
+static double m_timeElapsed{};
 
-// list of object instances
-GameObjInst			sGameObjInstList[GAME_OBJ_INST_NUM_MAX];	// Each element in this array represents a unique game object instance (sprite)
-static unsigned long		sGameObjInstNum;							// The number of used game object instances
+static const unsigned int INTEGRATE_GRAIN = 256;		// rows per integrate job, a multiple of the SIMD width
+static const unsigned int SERIALIZE_GRAIN = 256;		// objects per snapshot quantize job
 
-// pointer to the ship object
-static GameObjInst *		spShip;										// Pointer to the "Ship" game object instance
+// snapshot positions also cover the objects wrapping around the edges
+static const f32 SNAPSHOT_BOUNDS_MARGIN = 2.0f * BOUNDING_RECT_SIZE * ASTEROID_SIZE;
 
-// number of ship available (lives 0 = game over)
-static long					sShipLives;									// The number of lives left
+// priority a waiting change gains every snapshot, by type at the ship, halved
+// SNAPSHOT_PRIORITY_DISTANCE away from it
+static const f32 SNAPSHOT_TYPE_WEIGHT[TYPE_NUM] = { 4.0f, 1.0f, 2.0f };
+static const f32 SNAPSHOT_PRIORITY_DISTANCE = 100.0f;
 
-// the score = number of asteroid destroyed
-static unsigned long		sScore;										// Current score
+static const f64 SHARD_STATS_INTERVAL = 10.0;			// seconds between two load reports
 
-static bool onValueChange = true;
-static double m_timeElapsed{};
+static void BuildTickGraph(Room& room);
 
 
 SHIP_OBJ_INFO::SHIP_OBJ_INFO(int ded, int sid, int s, int l, float sc, AEVec2 p, AEVec2 v, float d) : dead{ded}, shipID { sid }, score{ s }, live{ l }, scale{ sc }, position{ p }, velCurr{ v }, dirCurr{ d } {}
@@ -69,10 +65,23 @@ SHIP_OBJ_INFO::SHIP_OBJ_INFO(int ded, int sid, int s, int l, float sc, AEVec2 p,
 OTHER_OBJ_INFO::OTHER_OBJ_INFO(int oid, int t, float s, AEVec2 p, AEVec2 v, float d) : objID{ oid }, type{ t }, scale{ s }, position{ p }, velCurr{ v }, dirCurr{ d } {}
 // ---------------------------------------------------------------------------
 
-// functions to create/destroy a game object instance
-GameObjInst *		gameObjInstCreate (unsigned long type, float scale, 
-											   AEVec2 * pPos, AEVec2 * pVel, float dir);
-void					gameObjInstDestroy(GameObjInst * pInst);
+
+/******************************************************************************/
+/*!
+	Picks a spawn position on the left edge and a random heading for an asteroid
+*/
+/******************************************************************************/
+static void RandomAsteroid(Room& room, AEVec2& pos, AEVec2& vel)
+{
+	// Create a uniform distribution for floats between 0 and 2π
+	std::uniform_real_distribution<float> dis(0.0f, 2.0f * 3.14159265358979323846f);
+	std::uniform_real_distribution<float> disY(PlatformGetWinMinY(), PlatformGetWinMaxY());
+
+	float asteroidDir = dis(room.random);
+	vel.x = cosf(asteroidDir) * ASTEROID_SPEED;
+	vel.y = sinf(asteroidDir) * ASTEROID_SPEED;
+	pos = { PlatformGetWinMinX() - 50.0f, disY(room.random) };
+}
 
 
 /******************************************************************************/
@@ -82,590 +91,771 @@ void					gameObjInstDestroy(GameObjInst * pInst);
 /******************************************************************************/
 void GameStateAsteroidsLoad(void)
 {
-	// zero the game object array
-	memset(sGameObjList, 0, sizeof(GameObj) * GAME_OBJ_NUM_MAX);
-	// No game objects (shapes) at this point
-	sGameObjNum = 0;
+	// no rooms at this point, they open as players join
+	SimKernelInit(g_simKernelIsa);
+	std::cout << "Simulation kernel: " << SimKernelGetIsaName(SimKernelGetIsa()) << "\n";
 
-	// zero the game object instance array
-	memset(sGameObjInstList, 0, sizeof(GameObjInst) * GAME_OBJ_INST_NUM_MAX);
-	// No game object instances (sprites) at this point
-	sGameObjInstNum = 0;
+	// an asteroid is the largest thing in the world, so it spans at most 2x2 cells
+	BroadphaseInit(g_broadphase, ASTEROID_SIZE);
+	std::cout << "Broadphase: " << BroadphaseGetTypeName(BroadphaseGetType()) << "\n";
+}
 
-	// The ship object instance hasn't been created yet, so this "spShip" pointer is initialized to 0
-	spShip = nullptr;
+/******************************************************************************/
+/*!
+	"Initialize" function of this state
+*/
+/******************************************************************************/
+void GameStateAsteroidsInit(void)
+{
+	// one tick rate for every shard, the asteroids are made with each room
+	SimClockInit(g_tickRate);
+	RoomsInit(ShardGetCount());
+
+	// several shards already keep every core busy, each runs its rooms alone.
+	// the shards are open by now, a port that can not be shared leaves one
+	JobSystemInit(ShardGetCount() > 1 ? 0 : g_workerCount);
+	std::cout << "Job workers: " << JobSystemGetWorkerCount() << "\n";
+
+	// the bits of every snapshot field come from the arguments, the ranges from the world
+	QuantizeConfig& q = g_quantize;
+	q.minX = PlatformGetWinMinX() - SNAPSHOT_BOUNDS_MARGIN;
+	q.maxX = PlatformGetWinMaxX() + SNAPSHOT_BOUNDS_MARGIN;
+	q.minY = PlatformGetWinMinY() - SNAPSHOT_BOUNDS_MARGIN;
+	q.maxY = PlatformGetWinMaxY() + SNAPSHOT_BOUNDS_MARGIN;
+	q.defaultScale[TYPE_SHIP] = SHIP_SIZE;
+	q.defaultScale[TYPE_BULLET] = BULLET_SIZE;
+	q.defaultScale[TYPE_ASTEROID] = ASTEROID_SIZE;
+	q.defaultScale[TYPE_NUM] = 1.0f;
+
+	// how far a velocity step moves an object in a tick, in position steps.
+	// both sides predict with it, so it is worked out once here and sent
+	f64 velocityStep = q.velocityMax / ((1u << q.velocityBits) - 1);
+	f64 positionSteps = static_cast<f64>((1u << q.positionBits) - 1);
+	f64 tickLength = 1.0 / SimClockGetTickRate();
+	q.driftX = static_cast<u32>(velocityStep * tickLength * positionSteps / (q.maxX - q.minX) * 65536.0 + 0.5);
+	q.driftY = static_cast<u32>(velocityStep * tickLength * positionSteps / (q.maxY - q.minY) * 65536.0 + 0.5);
+
+	std::cout << "Snapshot entity: " << SnapshotEntityBits(q, false, true) << " bits moving, "
+		<< SnapshotEntityBits(q, false, false) << " bits still, error at most "
+		<< std::max(QuantizeError(q.minX, q.maxX, q.positionBits), QuantizeError(q.minY, q.maxY, q.positionBits)) << " position, "
+		<< QuantizeError(-PI, PI, q.angleBits) << " rad, "
+		<< QuantizeError(-q.velocityMax, q.velocityMax, q.velocityBits) << " velocity, "
+		<< g_deltaTolerance * (q.maxX - q.minX) / ((1u << q.positionBits) - 1) << " more position between updates\n";
+}
 
-	// load/create the mesh data (game objects / Shapes)
-	GameObj * pObj;
 
-	// =====================
-	// create the ship shape
-	// =====================
+EntityHandle AddNewShip(Room& room)
+{
+	// Add a new SHip
+	EntityHandle shipID = EntityCreate(room.store, TYPE_SHIP, SHIP_SIZE, nullptr, nullptr, 0.0f);
+	AE_ASSERT(shipID != ENTITY_INVALID);
+	currentAliveObjects++;
 
-	pObj		= sGameObjList + sGameObjNum++;
-	pObj->type	= TYPE_SHIP;
+	// a ship owns its own entry in the ship table
+	room.store.owner[EntityRow(room.store, shipID)] = static_cast<int>(room.ships.size());
+	room.store.wrapMargin[EntityRow(room.store, shipID)] = SHIP_SIZE;
 
-	AEGfxMeshStart();
-	AEGfxTriAdd(
-		-0.5f,  0.5f, 0xFFFF0000, 0.0f, 0.0f, 
-		-0.5f, -0.5f, 0xFFFF0000, 0.0f, 0.0f,
-		 0.5f,  0.0f, 0xFFFFFFFF, 0.0f, 0.0f );  
+	SHIP_OBJ newShipData{};
+	newShipData.objectID = shipID;
+	newShipData.shipLive = 3;
+	room.ships.push_back(newShipData);
+	return shipID;
+}
 
-	pObj->pMesh = AEGfxMeshEnd();//saves triangles into pMesh
-	AE_ASSERT_MESG(pObj->pMesh, "fail to create object!!");
+EntityHandle FireBullet(Room& room, EntityHandle ship, AEVec2& pos, AEVec2& vel)
+{
+	EntityHandle bulletID = EntityCreate(room.store, TYPE_BULLET, BULLET_SIZE, &pos, &vel, 0.0f);
 
+	// the store is full, drop the shot rather than stop the server
+	if (bulletID == ENTITY_INVALID)
+		return ENTITY_INVALID;
 
-	// =======================
-	// create the bullet shape
-	// =======================
-	pObj = sGameObjList + sGameObjNum++;
-	pObj->type = TYPE_BULLET;
-	
-	AEGfxMeshStart();
-	AEGfxTriAdd(
-		-0.5f, -0.5f, 0xFFFF00FF, 0.0f, 1.0f,
-		0.5f, -0.5f, 0xFFFFFF00, 1.0f, 1.0f,
-		-0.5f, 0.5f, 0xFF00FFFF, 0.0f, 0.0f);
-
-	AEGfxTriAdd(
-		0.5f, -0.5f, 0xFFFFFFFF, 1.0f, 1.0f,
-		0.5f, 0.5f, 0xFFFFFFFF, 1.0f, 0.0f,
-		-0.5f, 0.5f, 0xFFFFFFFF, 0.0f, 0.0f);
-	pObj->pMesh = AEGfxMeshEnd();//saves triangles into pMesh
-	AE_ASSERT_MESG(pObj->pMesh, "fail to create object!!");
+	currentAliveObjects++;
+	room.store.owner[EntityRow(room.store, bulletID)] = room.store.owner[EntityRow(room.store, ship)];
 
-	// =========================
-	// create the asteroid shape
-	// =========================
-	pObj = sGameObjList + sGameObjNum++;
-	pObj->type = TYPE_ASTEROID;
-
-	AEGfxMeshStart();
-	AEGfxTriAdd(
-		-0.5f, -0.5f, 0xFFFFFFFF, 0.0f, 1.0f,
-		0.5f, -0.5f, 0xFFFFFFFF, 1.0f, 1.0f,
-		-0.5f, 0.5f, 0xFFFFFFFF, 0.0f, 0.0f);
-
-	AEGfxTriAdd(
-		0.5f, -0.5f, 0xFFFFFFFF, 1.0f, 1.0f,
-		0.5f, 0.5f, 0xFFFFFFFF, 1.0f, 0.0f,
-		-0.5f, 0.5f, 0xFFFFFFFF, 0.0f, 0.0f);
-	pObj->pMesh = AEGfxMeshEnd(); //saves triangles into pMesh
-	AE_ASSERT_MESG(pObj->pMesh, "fail to create object!!");
-	
+	return bulletID;
 }
 
 /******************************************************************************/
 /*!
-	"Initialize" function of this state
+	Applies the keys a player held during one tick to its ship, called by the
+	room's tick
 */
 /******************************************************************************/
-void GameStateAsteroidsInit(void)
-{
-	// create the main ship
-
-	//// Ship ID 0
-/*	spShip = gameObjInstCreate(TYPE_SHIP, SHIP_SIZE, nullptr, nullptr, 0.0f);
-	AE_ASSERT(spShip);*/	
-	//currentAliveObjects++;
-	//
-	// CREATE THE INITIAL ASTEROIDS INSTANCES USING THE "gameObjInstCreate" FUNCTION
-	
-	AEVec2 asteroidVelocity;
-	AEVec2 asteroidPos;
-	std::random_device rd;
-	std::mt19937 gen(rd());
+void ApplyShipInput(Room& room, EntityHandle shipHandle, InputKeys keys) {
+	const float					SHIP_ACCEL_FORWARD = 60.0f;			// ship forward acceleration (in m/s^2)
+	const float					SHIP_ACCEL_BACKWARD = 60.0f;		// ship backward acceleration (in m/s^2)
+	const float					SHIP_ROT_SPEED = (2.0f * PI);		// ship rotation speed (degree/second)
 
-	// Create a uniform distribution for floats between 0 and 2π
-	std::uniform_real_distribution<float> dis(0.0f, 2.0f * 3.14159265358979323846f);
-	for (int i = 0; i < 4; i++) {
-		// Generate a random float between 0 and 2π
-		float asteroidDir = dis(gen);
-		asteroidVelocity.x = cosf(asteroidDir) * ASTEROID_SPEED;
-		asteroidVelocity.y = sinf(asteroidDir) * ASTEROID_SPEED;
-		asteroidPos = { AEGfxGetWinMinX() - 50.0f, ((std::rand() % static_cast<int>((AEGfxGetWinMinY() - AEGfxGetWinMaxY() + 1)) + AEGfxGetWinMinY() ))};
-		auto goptr = gameObjInstCreate(TYPE_ASTEROID, ASTEROID_SIZE, &asteroidPos, &asteroidVelocity, 0.0f);
-		allOtherObjsInfo.push_back(goptr);
+	// inputs are scaled by the fixed tick, not by how long the last frame took
+	const float					dt = SimClockGetStep();
+
+	EntityStore& e{ room.store };
+
+	// ignore ids of dead, recycled or non ship entities
+	if (!EntityIsAlive(e, shipHandle) || e.type[EntityRow(e, shipHandle)] != TYPE_SHIP) {
+		return;
 	}
 
-	// Creates initial bullet instance
-	//GameObjInst * bullet = gameObjInstCreate(TYPE_BULLET, 0, nullptr, nullptr, 0.0f);
-	//gameObjInstDestroy(bullet);
-	
+	unsigned int const ship{ EntityRow(e, shipHandle) };
 
-	// reset the score and the number of ships
-	//sScore      = 0;
-	//sShipLives  = 0;
-}
+	if (keys & INPUT_KEY_UP) {
+		AEVec2 accel{ static_cast<f32>(cosf(e.dir[ship])),
+			static_cast<f32>(sinf(e.dir[ship])) }; //normalized acceleration vector
 
+		accel = { accel.x * SHIP_ACCEL_FORWARD, accel.y * SHIP_ACCEL_FORWARD }; //full acceleration vector
+		e.velX[ship] = (accel.x * dt + e.velX[ship]) * static_cast<f32>(0.99);
+		e.velY[ship] = (accel.y * dt + e.velY[ship]) * static_cast<f32>(0.99);
+	}
 
-int AddNewShip()
-{
-	std::lock_guard<std::mutex> lock(GAME_OBJECT_LIST_MUTEX);
-	// Add a new SHip
-	GameObjInst* newShipInst = gameObjInstCreate(TYPE_SHIP, SHIP_SIZE, nullptr, nullptr, 0.0f);	
-	AE_ASSERT(newShipInst);
-	currentAliveObjects++;
+	if (keys & INPUT_KEY_DOWN) {
+		AEVec2 accel{ static_cast<f32>(-cosf(e.dir[ship])), 
+			static_cast<f32>(-sinf(e.dir[ship])) }; //normalized acceleration vector
+		accel = { accel.x * SHIP_ACCEL_BACKWARD, accel.y * SHIP_ACCEL_BACKWARD }; //full acceleration vector
+		e.velX[ship] = (accel.x * dt + e.velX[ship]) * static_cast<f32>(0.99);
+		e.velY[ship] = (accel.y * dt + e.velY[ship]) * static_cast<f32>(0.99);
+	}
 
-	unsigned int shipID = newShipInst - sGameObjInstList;
-	SHIP_OBJ newShipData{};
-	newShipData.objectID = static_cast<int>(shipID);
-	newShipData.shipLive = 3;
-	allShipInfo.push_back(newShipData);
-	return static_cast<int>(shipID);
+	if (keys & INPUT_KEY_LEFT) {
+		e.dir[ship] += SHIP_ROT_SPEED * dt;
+		e.dir[ship] = PlatformWrap(e.dir[ship], -PI, PI);
+	}
 
- //reset the score and the number of ship
-}
+	if (keys & INPUT_KEY_RIGHT) {
+		e.dir[ship] -= SHIP_ROT_SPEED * dt;
+		e.dir[ship] = PlatformWrap(e.dir[ship], -PI, PI);
+	}
 
-int FireBullet(int shipid, AEVec2& pos, AEVec2& vel)
-{
-	GameObjInst* newBulletInst = gameObjInstCreate(TYPE_BULLET, BULLET_SIZE, &pos, &vel, 0.0f);
-	AE_ASSERT(newBulletInst);
-	currentAliveObjects++;
-	newBulletInst->fromShipIdx = shipid;
-	unsigned int bulletID = newBulletInst - sGameObjInstList;
-	GameObjInst* newBulletData{};
-	allOtherObjsInfo.push_back(newBulletInst);
+	if (keys & INPUT_KEY_SHOOT) {
+		AEVec2 vel{ cosf(e.dir[ship]), sinf(e.dir[ship]) };
+		vel.x = vel.x * BULLET_SPEED;
+		vel.y = vel.y * BULLET_SPEED;
 
-	return static_cast<int>(bulletID);
+		// Create an instance
+		AEVec2 pos{ e.posX[ship], e.posY[ship] };
+		FireBullet(room, shipHandle, pos, vel);
+	}
 }
 
-
 /******************************************************************************/
 /*!
-	"Update" function of this state
+	Opens a room: seeds its random stream, so a seeded run replays exactly,
+	makes its first asteroids and lays out its tick
 */
 /******************************************************************************/
-void GameStateAsteroidsUpdate(void)
+static void RoomStart(Room& room)
 {
-	// =========================
-	// receive from client
-	// =========================
-	// Done in main
+	room.random.seed(g_randomSeed ? g_randomSeed + room.id : std::random_device{}());
 
-	// =========================
-	// update according to input
-	// =========================
-	// Done in main172.28.80.1
+	AEVec2 asteroidVelocity;
+	AEVec2 asteroidPos;
+	for (int i = 0; i < 4; i++) {
+		RandomAsteroid(room, asteroidPos, asteroidVelocity);
+		EntityHandle id = EntityCreate(room.store, TYPE_ASTEROID, ASTEROID_SIZE, &asteroidPos, &asteroidVelocity, 0.0f);
+		room.store.wrapMargin[EntityRow(room.store, id)] = BOUNDING_RECT_SIZE * ASTEROID_SIZE;
+	}
 
-	m_timeElapsed += AEFrameRateControllerGetFrameTime();
+	BuildTickGraph(room);
+}
+
+Room* JoinRoom(unsigned int shard, SOCKET socket, const sockaddr_in& address, EntityHandle& ship)
+{
+	// the reply to a join can get lost, a second join gets the same answer
+	unsigned int client;
+	Room* room = RoomFindClient(shard, address, &client);
+	if (room) {
+		ship = room->ships[client].objectID;
+		return room;
+	}
 
-	std::lock_guard<std::mutex> lock(GAME_OBJECT_LIST_MUTEX);
+	room = RoomFindOpen(shard);
+	if (!room) {
+		room = RoomCreate(shard, socket);
+		if (!room)
+			return nullptr;
+		RoomStart(*room);
+	}
 
-	// ======================================================
-	// update physics of all active game object instances
-	//  -- Get the AABB bounding rectangle of every active instance:
-	//		boundingRect_min = -(BOUNDING_RECT_SIZE/2.0f) * instance->scale + instance->pos
-	//		boundingRect_max = +(BOUNDING_RECT_SIZE/2.0f) * instance->scale + instance->pos
-	//
-	//	-- Positions of the instances are updated here with the already computed velocity (above)
-	// ======================================================
+	ship = AddNewShip(*room);
+	RoomAddClient(*room, address);
+	return room;
+}
 
-	for (unsigned long i = 0; i < GAME_OBJ_INST_NUM_MAX; i++)
-	{
+void RoomQueueInput(Room& room, const sockaddr_in& from, const CLIENT_MESSAGE_FORMAT& message)
+{
+	EntityStore& e{ room.store };
+	EntityHandle const shipHandle{ static_cast<EntityHandle>(message.ShipID) };
 
-		GameObjInst* pInst = sGameObjInstList + i;
+	// ignore ids of dead, recycled or non ship entities
+	if (!EntityIsAlive(e, shipHandle) || e.type[EntityRow(e, shipHandle)] != TYPE_SHIP)
+		return;
 
-		if ((pInst->flag & FLAG_ACTIVE) == 0)
-			continue;
+	// only the player who owns the ship steers it, anyone else naming its
+	// id is dropped
+	unsigned int player = static_cast<unsigned int>(e.owner[EntityRow(e, shipHandle)]);
+	if (player >= room.clients.size()
+		|| room.clients[player].sin_addr.s_addr != from.sin_addr.s_addr
+		|| room.clients[player].sin_port != from.sin_port)
+		return;
 
-		pInst->boundingBox.min.x = pInst->posCurr.x - (((BOUNDING_RECT_SIZE / 2.0f) * pInst->scale));
-		pInst->boundingBox.min.y = pInst->posCurr.y - (((BOUNDING_RECT_SIZE / 2.0f) * pInst->scale));
+	room.heard[player] = SimClockGetTick();
+	InputBufferAdd(room.inputs[player], static_cast<u32>(message.Tick), message.Keys, INPUT_REDUNDANCY);
 
-		pInst->boundingBox.max.x = pInst->posCurr.x + (((BOUNDING_RECT_SIZE / 2.0f) * pInst->scale));
-		pInst->boundingBox.max.y = pInst->posCurr.y + (((BOUNDING_RECT_SIZE / 2.0f) * pInst->scale));
+	// the next snapshots are deltas from the newest one the client has
+	SnapshotHistory& history = room.snapshots[player];
+	if (message.Ack != SNAPSHOT_NONE
+		&& (history.acked == SNAPSHOT_NONE || static_cast<s32>(message.Ack - history.acked) > 0))
+		history.acked = message.Ack;
+}
 
-		pInst->posCurr = { pInst->velCurr.x * static_cast<f32>(AEFrameRateControllerGetFrameTime()) + pInst->posCurr.x,
-			pInst->velCurr.y * static_cast<f32>(AEFrameRateControllerGetFrameTime()) + pInst->posCurr.y };
 
-		if (sScore >= 5000) {
-			if (pInst->pObject->type == TYPE_SHIP) {
-				//Reset Ship Position
-				AEVec2 zero = { 0,0 };
-				pInst->velCurr = zero;
-				pInst->posCurr = zero;
-			}
-		}
-	}
-	
-	// ====================
-	// check for collision
-	// ====================
-	for (unsigned long i = 0; i < GAME_OBJ_INST_NUM_MAX; i++)
+/******************************************************************************/
+/*!
+	Resolution stage: applies the events in the order of the slots involved,
+	so the outcome only depends on what touched what:
+		-- a ship loses at most one life per tick
+		-- a bullet scores for the first asteroid it hit and is used up
+		-- an asteroid respawns once however many bullets hit it
+*/
+/******************************************************************************/
+static void ResolveCollisions(Room& room)
+{
+	EntityStore& e = room.store;
+
+	std::sort(room.eventScratch.begin(), room.eventScratch.end(),
+		[&e](const CollisionEvent& a, const CollisionEvent& b) {
+			if (e.slotOf[a.asteroid] != e.slotOf[b.asteroid])
+				return e.slotOf[a.asteroid] < e.slotOf[b.asteroid];
+			return e.slotOf[a.target] < e.slotOf[b.target];
+		});
+
+	room.resolvedScratch.assign(e.count, 0);
+	for (const CollisionEvent& ev : room.eventScratch)
 	{
-		GameObjInst* pInst = sGameObjInstList + i;
+		unsigned int i = ev.asteroid;
+		unsigned int x = ev.target;
 
-		if ((pInst->flag & FLAG_ACTIVE) == 0)
+		if (room.resolvedScratch[x])
 			continue;
 
-		if (pInst->pObject->type == TYPE_ASTEROID) {
-			for (unsigned long x = 0; x < GAME_OBJ_INST_NUM_MAX; x++)
-			{
-				GameObjInst* pInst2 = sGameObjInstList + x;
-				if ((pInst2->flag & FLAG_ACTIVE) == 0)
-					continue;
-
-				if (pInst2->pObject->type == TYPE_SHIP) {		
-					if (CollisionIntersection_RectRect(pInst->boundingBox, pInst->velCurr, pInst2->boundingBox, pInst2->velCurr)) {
-						//gameObjInstDestroy(pInst);
-
-						//Reset Ship Position
-
-						if (!allShipInfo[x].isDead) {
-							//Reset Ship Position
-							AEVec2 zero = { 0,0 };
-							pInst2->velCurr = zero;
-							pInst2->posCurr = zero;
-							if (--allShipInfo[x].shipLive < 0) {
-								allShipInfo[x].score = -1;
-								allShipInfo[x].isDead = true;
-							}
-						}
-					}
-				}
-				if (pInst2->pObject->type == TYPE_BULLET) {
-					if (CollisionIntersection_RectRect(pInst->boundingBox, pInst->velCurr, pInst2->boundingBox, pInst2->velCurr)) {
-						//gameObjInstDestroy(pInst);
-						AEVec2 asteroidVelocity;
-						AEVec2 asteroidPos;
-						std::random_device rd;
-						std::mt19937 gen(rd());
-
-						// Create a uniform distribution for floats between 0 and 2π
-						std::uniform_real_distribution<float> dis(0.0f, 2.0f * 3.14159265358979323846f);
-
-						float asteroidDir = dis(gen);
-						asteroidVelocity.x = cosf(asteroidDir) * ASTEROID_SPEED;
-						asteroidVelocity.y = sinf(asteroidDir) * ASTEROID_SPEED;
-						asteroidPos = { AEGfxGetWinMinX() - 50.0f, ((std::rand() % static_cast<int>((AEGfxGetWinMinY() - AEGfxGetWinMaxY() + 1)) + AEGfxGetWinMinY())) };
-						gameObjInstSet(i, TYPE_ASTEROID, ASTEROID_SIZE, &asteroidPos, &asteroidVelocity, 0.0f);
-
-						allShipInfo[pInst2->fromShipIdx].score += 10;
-
-						gameObjInstDestroy(pInst2);
-						auto it = std::find(allOtherObjsInfo.begin(), allOtherObjsInfo.end(), pInst2);
-
-						// Check if the element was found
-						if (it != allOtherObjsInfo.end()) {
-							// Erase the element from the vector
-							allOtherObjsInfo.erase(it);
-						}
-					}
+		if (e.type[x] == TYPE_SHIP) {		
+			room.resolvedScratch[x] = 1;
+			SHIP_OBJ& ship = room.ships[e.owner[x]];
+			if (!ship.isDead) {
+				//Reset Ship Position
+				e.velX[x] = e.velY[x] = 0.0f;
+				e.posX[x] = e.posY[x] = 0.0f;
+				if (--ship.shipLive < 0) {
+					ship.score = -1;
+					ship.isDead = true;
 				}
 			}
 		}
+		if (e.type[x] == TYPE_BULLET) {
+			room.resolvedScratch[x] = 1;
+			room.ships[e.owner[x]].score += 10;
+			room.cullScratch.push_back(EntityHandleOfRow(e, x));
+
+			if (!room.resolvedScratch[i]) {
+				room.resolvedScratch[i] = 1;
+				AEVec2 asteroidVelocity;
+				AEVec2 asteroidPos;
+				RandomAsteroid(room, asteroidPos, asteroidVelocity);
+				EntitySet(e, EntityHandleOfRow(e, i), TYPE_ASTEROID, ASTEROID_SIZE, &asteroidPos, &asteroidVelocity, 0.0f);
+			}
+		}
 	}
+}
 
-	// ===================================
-	// update active game object instances
-	// Example:
-	//		-- Wrap specific object instances around the world (Needed for the assignment)
-	//		-- Removing the bullets as they go out of bounds (Needed for the assignment)
-	//		-- If you have a homing missile for example, compute its new orientation 
-	//			(Homing missiles are not required for the Asteroids project)
-	//		-- Update a particle effect (Not required for the Asteroids project)
-	// ===================================
-	for (unsigned long i = 0; i < GAME_OBJ_INST_NUM_MAX; i++)
+/******************************************************************************/
+/*!
+	Input phase: exactly one input per player and tick, however many
+	datagrams came in. it turns ships and fires bullets, so it runs before
+	anything moves
+*/
+/******************************************************************************/
+static void InputPhase(Room& room)
+{
+	for (size_t i = 0; i < room.ships.size(); ++i)
 	{
-		GameObjInst * pInst = sGameObjInstList + i;
+		InputKeys keys = InputBufferTake(room.inputs[i]);
+		if (keys)
+			ApplyShipInput(room, room.ships[i].objectID, keys);
+	}
+}
 
-		// skip non-active object
-		if ((pInst->flag & FLAG_ACTIVE) == 0)
-			continue;
-		
-		// check if the object is a ship
-		if (pInst->pObject->type == TYPE_SHIP)
-		{
-			// warp the ship from one end of the screen to the other
-			pInst->posCurr.x = AEWrap(pInst->posCurr.x, AEGfxGetWinMinX() - SHIP_SIZE, 
-														AEGfxGetWinMaxX() + SHIP_SIZE);
-			pInst->posCurr.y = AEWrap(pInst->posCurr.y, AEGfxGetWinMinY() - SHIP_SIZE, 
-														AEGfxGetWinMaxY() + SHIP_SIZE);
-		}
+/******************************************************************************/
+/*!
+	Integrate phase: updates the physics of every live row, the rows are packed
+		-- Get the AABB bounding rectangle from the position at the start of the tick
+		-- Integrate the position with the current velocity
+		-- Wrap ships and asteroids around the world, bullets never wrap
+	rows do not depend on each other, so ranges of them run side by side
+*/
+/******************************************************************************/
+static void IntegratePhase(Room& room)
+{
+	EntityStore& e = room.store;
 
-		// Wrap asteroids here
-		if (pInst->pObject->type == TYPE_ASTEROID)
-		{
-			// warp the ship from one end of the screen to the other
-			pInst->posCurr.x = AEWrap(pInst->posCurr.x, AEGfxGetWinMinX() - (BOUNDING_RECT_SIZE * pInst->scale),
-				AEGfxGetWinMaxX() + (BOUNDING_RECT_SIZE * pInst->scale));
-			pInst->posCurr.y = AEWrap(pInst->posCurr.y, AEGfxGetWinMinY() - (BOUNDING_RECT_SIZE * pInst->scale),
-				AEGfxGetWinMaxY() + (BOUNDING_RECT_SIZE * pInst->scale));
-		}
+	JobParallelFor(e.count, INTEGRATE_GRAIN, [&room](unsigned int begin, unsigned int end) {
+		SimKernelIntegrateWrap(room.store, begin, end, room.stepDt, BOUNDING_RECT_SIZE / 2.0f, room.stepBounds);
+	});
+}
 
-		// Remove bullets that go out of bounds
-		if (pInst->pObject->type == TYPE_BULLET) {
-			if (pInst->posCurr.x < AEGfxGetWinMinX() || pInst->posCurr.x > AEGfxGetWinMaxX() || pInst->posCurr.y > AEGfxGetWinMaxY() || pInst->posCurr.y < AEGfxGetWinMinY()) {
-				gameObjInstDestroy(pInst);
-				auto it = std::find(allOtherObjsInfo.begin(), allOtherObjsInfo.end(), pInst);
+/******************************************************************************/
+/*!
+	Gather phase: lists the asteroids and what they can hit, and flags the
+	bullets that went out of bounds, they still collide this tick and are
+	removed after the collision pass
+*/
+/******************************************************************************/
+static void GatherPhase(Room& room)
+{
+	EntityStore& e = room.store;
+	const SimBounds& bounds = room.stepBounds;
 
-				// Check if the element was found
-				if (it != allOtherObjsInfo.end()) {
-					// Erase the element from the vector
-					allOtherObjsInfo.erase(it);
-				}
-			}
+	room.cullScratch.clear();
+	room.asteroidScratch.clear();
+	room.targetScratch.clear();
+	for (unsigned int i = 0; i < e.count; i++)
+	{
+		if (e.type[i] == TYPE_ASTEROID)
+			room.asteroidScratch.push_back(i);
+		else
+			room.targetScratch.push_back(i);
+
+		if (e.type[i] == TYPE_BULLET) {
+			if (e.posX[i] < bounds.minX || e.posX[i] > bounds.maxX || e.posY[i] > bounds.maxY || e.posY[i] < bounds.minY)
+				room.cullScratch.push_back(EntityHandleOfRow(e, i));
 		}
 	}
-	
-	// =====================================
-	// calculate the matrix for all objects
-	// =====================================
+}
 
-	for (unsigned long i = 0; i < GAME_OBJ_INST_NUM_MAX; i++)
-	{
-		GameObjInst * pInst = sGameObjInstList + i;
-		AEMtx33		 trans = {0}, rot = {0}, scale = {0};
+/******************************************************************************/
+/*!
+	Broadphase and narrowphase: only the pairs the broadphase found go through
+	the narrowphase. hits are queued and applied afterwards, nothing is
+	destroyed before the end of the tick, so the rows stay put meanwhile
+*/
+/******************************************************************************/
+static void BroadphasePhase(Room& room)
+{
+	BroadphaseFindPairs(*room.broadphase, room.store, room.stepDt, room.stepBounds,
+		room.asteroidScratch, room.targetScratch, room.pairScratch);
+}
 
-		UNREFERENCED_PARAMETER(trans);
-		UNREFERENCED_PARAMETER(rot);
-		UNREFERENCED_PARAMETER(scale);
+static void NarrowphasePhase(Room& room)
+{
+	DetectCollisions(room, room.stepDt);
+}
 
-		// skip non-active object
-		if ((pInst->flag & FLAG_ACTIVE) == 0)
-			continue;
+/******************************************************************************/
+/*!
+	Resolve phase: applies the hits, then removes the bullets that left the
+	world or hit an asteroid, one flagged twice is stale the second time and
+	skipped. the store keeps its rows packed, nothing else lists them
+*/
+/******************************************************************************/
+static void ResolvePhase(Room& room)
+{
+	ResolveCollisions(room);
 
-		// Compute the scaling matrix
-		// Compute the rotation matrix 
-		// Compute the translation matrix
-		// Concatenate the 3 matrix in the correct order in the object instance's "transform" matrix
-		AEMtx33Scale(&scale, pInst->scale, pInst->scale);
+	for (EntityHandle bullet : room.cullScratch)
+		EntityDestroy(room.store, bullet);
+}
 
-		AEMtx33Rot(&rot, pInst->dirCurr);
+/******************************************************************************/
+/*!
+	Serialize phase: quantizes the ships and objects once for all the
+	players and buckets the objects for interest, RoomSendSnapshot then only
+	diffs and sends per player. only the last tick before a send does it
+*/
+/******************************************************************************/
+static void SerializePhase(Room& room)
+{
+	if (!room.stepSnapshot)
+		return;
 
-		AEMtx33Trans(&trans, pInst->posCurr.x, pInst->posCurr.y);
+	std::vector<SHIP_OBJ_INFO>& shipMsg = room.shipScratch;
+	shipMsg.clear();
+	int numofShips{};
 
-		// Concat the matrices (TRS)
-		AEMtx33Concat(&pInst->transform, &rot, &scale);
-		AEMtx33Concat(&pInst->transform, &trans, &pInst->transform);
-	}
-	
-	if (m_timeElapsed >= 0.01)
+	for (const SHIP_OBJ& s : room.ships)
 	{
-		m_timeElapsed = 0.0;
-		// ========================================
-		// send new position information to clients
-		// ========================================
-		// Send Position Info to client
-
-		//Generate the Message 
-		//static std::vector<SHIP_OBJ> allShipInfo{};
-		//static std::vector<GameObj*> allOtherObjsInfo{};
-		std::vector<SHIP_OBJ_INFO> shipMsg{};
-		std::vector<OTHER_OBJ_INFO> otherObjMsg{};
-		int numofShips{};
-		int numofObjs{ static_cast<int>(allOtherObjsInfo.size()) };
-		//std::cout << allShipInfo.size() << "::num Of Ships Created\n";
-
-		
-		for (const SHIP_OBJ& s : allShipInfo)
-		{
-			//if (s.isDead)
-			//	continue;
-			++numofShips;
-			shipMsg.emplace_back(
-				(int)s.isDead,
-				s.objectID, 
-				s.score,
-				s.shipLive,
-				sGameObjInstList[s.objectID].scale,
-				sGameObjInstList[s.objectID].posCurr, 
-				sGameObjInstList[s.objectID].velCurr,
-				sGameObjInstList[s.objectID].dirCurr);
-		}
-		int numalive{};
-		int idxalive{};
-		for (int i{}; i < allShipInfo.size(); ++i) {
-			if (allShipInfo[i].isDead)continue;
-			numalive++;
-			idxalive = i;
-		}
-		if (numalive == 1 && numofShips > 1) {
-			shipMsg[idxalive].live = 1234;
-		}
-		else if (numalive == 0) {
-			shipMsg[rand() % MAX_CLIENTS].live = 1234;
-		}
-
-		for (GameObjInst* o : allOtherObjsInfo)
-		{
-			otherObjMsg.emplace_back(
-				o-sGameObjInstList, 
-				o->pObject->type,  
-				o->scale,
-				o->posCurr,
-				o->velCurr,
-				o->dirCurr);
-		}
+		++numofShips;
+		unsigned int id = EntityRow(room.store, s.objectID);
+		shipMsg.emplace_back(
+			(int)s.isDead,
+			static_cast<int>(EntityIndex(s.objectID)), 
+			s.score,
+			s.shipLive,
+			room.store.scale[id],
+			AEVec2{ room.store.posX[id], room.store.posY[id] },
+			AEVec2{ room.store.velX[id], room.store.velY[id] },
+			room.store.dir[id]);
+	}
+	int numalive{};
+	size_t idxalive{};
+	for (size_t i{}; i < room.ships.size(); ++i) {
+		if (room.ships[i].isDead)continue;
+		numalive++;
+		idxalive = i;
+	}
+	if (numalive == 1 && numofShips > 1) {
+		shipMsg[idxalive].live = 1234;
+	}
+	else if (numalive == 0 && numofShips > 0) {
+		// from the room's own stream, a seeded run sends the same
+		std::uniform_int_distribution<int> pick(0, numofShips - 1);
+		shipMsg[pick(room.random)].live = 1234;
+	}
 
-		size_t sizeNeeded = (2 * sizeof(int)) + (shipMsg.size() * sizeof(SHIP_OBJ_INFO)) + (otherObjMsg.size() * sizeof(OTHER_OBJ_INFO));
-		std::string text(sizeNeeded, ' ');
-		memcpy(&text[0], &numofShips, sizeof(int));
-		memcpy(&text[sizeof(int)], &numofObjs, sizeof(int));
-		for (int x{ 0 }; x < numofShips; ++x)
-		{
-			memcpy(&text[(2 * sizeof(int)) + (x* sizeof(SHIP_OBJ_INFO))], &shipMsg[x], sizeof(SHIP_OBJ_INFO));
-		}
+	// every bullet and asteroid quantized once for all the players, in slot
+	// order like the baselines. they are the live rows that are not ships
+	room.objectScratch.clear();
+	for (unsigned int o = 0; o < room.store.count; ++o)
+	{
+		if (room.store.type[o] != TYPE_SHIP)
+			room.objectScratch.push_back(o);
+	}
 
-		for (int x{ 0 }; x < numofObjs; ++x)
+	const QuantizeConfig& config = g_quantize;
+	std::vector<EntityState>& objects = room.snapshotScratch;
+	unsigned int numofObjs = static_cast<unsigned int>(room.objectScratch.size());
+	objects.resize(numofObjs);
+	JobParallelFor(numofObjs, SERIALIZE_GRAIN, [&room, &config, &objects](unsigned int begin, unsigned int end) {
+		for (unsigned int x = begin; x < end; ++x)
 		{
-			memcpy(&text[(2 * sizeof(int)) + (shipMsg.size() * sizeof(SHIP_OBJ_INFO)) + (x * sizeof(OTHER_OBJ_INFO))], &otherObjMsg[x], sizeof(OTHER_OBJ_INFO));
+			// the wire carries slot indices, the client draws by slot
+			unsigned int o = room.objectScratch[x];
+			EntityHandle h = EntityHandleOfRow(room.store, o);
+			SnapshotEntity entity{ EntityIndex(h), static_cast<u8>(room.store.type[o]), room.store.scale[o],
+				room.store.posX[o], room.store.posY[o], room.store.velX[o], room.store.velY[o], room.store.dir[o] };
+			EntityStateQuantize(config, entity, objects[x]);
+			objects[x].id = h;
 		}
+	});
+	std::sort(objects.begin(), objects.end(),
+		[](const EntityState& a, const EntityState& b) { return a.slot < b.slot; });
 
-
-		for (size_t i{0};i<ClientSocket.size();++i)
+	// bucketed once, every player then only looks at the cells around its ship
+	if (InterestEnabled(g_interest))
+	{
+		InterestGrid& grid = room.interestGrid;
+		grid.posX.resize(objects.size());
+		grid.posY.resize(objects.size());
+		grid.margins.resize(objects.size());
+		grid.slots.resize(objects.size());
+		for (size_t x{}; x < objects.size(); ++x)
 		{
-			int clientAddrLen = sizeof(ClientSocket[i]);
-			int errorCode = sendto(listenerSocket,
-				text.c_str(),
-				static_cast<int>(text.size()),
-				0,
-				reinterpret_cast<sockaddr*>(&ClientSocket[i]),
-				clientAddrLen);
-
-			if (errorCode == SOCKET_ERROR) {
-				std::cerr << "sendto() failed: " << WSAGetLastError() << std::endl;
-			}
+			unsigned int o = EntityRow(room.store, objects[x].id);
+			grid.posX[x] = room.store.posX[o];
+			grid.posY[x] = room.store.posY[o];
+			grid.margins[x] = room.store.wrapMargin[o];
+			grid.slots[x] = objects[x].slot;
 		}
+		f32 extent = g_interest.radius > 0.0f ? g_interest.radius : std::max(g_interest.halfWidth, g_interest.halfHeight);
+		InterestGridBuild(grid, room.stepBounds, std::max(extent, ASTEROID_SIZE));
+	}
 
-		/*for (int x{}; x < MAX_CLIENTS; ++x) {
-			for (int i{}; i < currentAliveObjects; ++i) {
-				int clientAddrLen = sizeof(ClientSocket[i]);
-				SERVER_MESSAGE_FORMAT toSend{};
-				toSend.ObjectID = i;
-				toSend.position = sGameObjInstList[i].posCurr;
-				toSend.dirCurr = sGameObjInstList[i].dirCurr;
-
-		
-			}
-		}*/
+	// the ships go first in every snapshot, whole
+	std::vector<EntityState>& ships = room.shipStateScratch;
+	ships.resize(shipMsg.size());
+	room.shipBits = 0;
+	for (size_t s{}; s < shipMsg.size(); ++s)
+	{
+		const SHIP_OBJ_INFO& ship = shipMsg[s];
+		SnapshotEntity entity{ static_cast<u32>(ship.shipID), TYPE_SHIP, ship.scale,
+			ship.position.x, ship.position.y, ship.velCurr.x, ship.velCurr.y, ship.dirCurr };
+		EntityStateQuantize(config, entity, ships[s]);
+		room.shipBits += 1 + PROTOCOL_LIVES_BITS + 32
+			+ SnapshotEntityBits(config, ships[s].scale != config.defaultScale[TYPE_SHIP], ships[s].moving);
 	}
 }
 
 /******************************************************************************/
 /*!
-	Draws objects so that they can be seen on screen
+	Lays the phases of a tick out as a graph:
+		input -> integrate -> gather -> broadphase -> narrowphase -> resolve -> serialize
 */
 /******************************************************************************/
+static void BuildTickGraph(Room& room)
+{
+	Room* r = &room;
+	JobGraphClear(room.tickGraph);
+
+	Job* input				= JobGraphAdd(room.tickGraph, [r] { InputPhase(*r); });
+	Job* integrate		= JobGraphAdd(room.tickGraph, [r] { IntegratePhase(*r); });
+	Job* gather				= JobGraphAdd(room.tickGraph, [r] { GatherPhase(*r); });
+	Job* broadphase		= JobGraphAdd(room.tickGraph, [r] { BroadphasePhase(*r); });
+	Job* narrowphase	= JobGraphAdd(room.tickGraph, [r] { NarrowphasePhase(*r); });
+	Job* resolve			= JobGraphAdd(room.tickGraph, [r] { ResolvePhase(*r); });
+	Job* serialize		= JobGraphAdd(room.tickGraph, [r] { SerializePhase(*r); });
+
+	JobGraphDepend(integrate, input);
+	JobGraphDepend(gather, integrate);
+	JobGraphDepend(broadphase, gather);
+	JobGraphDepend(narrowphase, broadphase);
+	JobGraphDepend(resolve, narrowphase);
+	JobGraphDepend(serialize, resolve);
+}
 
-// TO REMOVE AS SERVER SHOULDNT DRAW
-void GameStateAsteroidsDraw(void)
+/******************************************************************************/
+/*!
+	Simulates one fixed length tick of a room
+*/
+/******************************************************************************/
+void RoomStep(Room& room, f32 dt, bool snapshot)
 {
-	
+	room.stepDt = dt;
+	room.stepSnapshot = snapshot;
+	room.stepBounds = SimBounds{ PlatformGetWinMinX(), PlatformGetWinMaxX(), PlatformGetWinMinY(), PlatformGetWinMaxY() };
+
+	JobGraphRun(room.tickGraph);
 }
 
 /******************************************************************************/
 /*!
-	Frees gameObjects using the gameObjInstDestroy function
+	"Update" function of this state
 */
 /******************************************************************************/
-void GameStateAsteroidsFree(void)
+void GameStateAsteroidsUpdate(void)
 {
-	// kill all object instances in the array using "gameObjInstDestroy"
-	for (unsigned long i = 0; i < GAME_OBJ_INST_NUM_MAX; i++)
+	// =========================
+	// receive from client
+	// =========================
+	// Done by the shards
+
+	// =========================
+	// update according to input
+	// =========================
+	// Done by the shards, they also run the ticks and send the snapshots
+
+	m_timeElapsed += PlatformGetFrameTime();
+	if (m_timeElapsed < SHARD_STATS_INTERVAL)
+		return;
+
+	// ==========================================================
+	// report the load of every shard since the last report
+	// ==========================================================
+	static ShardStats last[SHARD_NUM_MAX]{};
+	for (unsigned int i = 0; i < ShardGetCount(); ++i)
 	{
-		GameObjInst* pInst = sGameObjInstList + i;
-		gameObjInstDestroy(pInst);
+		ShardStats now;
+		ShardGetStats(i, now);
+
+		u64 ticks = now.ticks - last[i].ticks;
+		if (now.rooms > 0) {
+			std::cout << "Shard " << i << ": " << now.rooms << " rooms, " << now.players << " players, "
+				<< static_cast<u64>(ticks / m_timeElapsed) << " ticks/s, "
+				<< (ticks ? (now.tickMicroseconds - last[i].tickMicroseconds) / ticks : 0) << " us/tick, "
+				<< static_cast<u64>((now.packetsIn - last[i].packetsIn) / m_timeElapsed) << " in/s, "
+				<< static_cast<u64>((now.packetsOut - last[i].packetsOut) / m_timeElapsed) << " out/s, "
+				<< static_cast<u64>((now.bytesOut - last[i].bytesOut) / m_timeElapsed / 1024) << " KB/s out, "
+				<< now.forwarded - last[i].forwarded << " forwarded, "
+				<< now.dropped - last[i].dropped << " dropped\n";
+		}
+		last[i] = now;
 	}
+
+	m_timeElapsed = 0.0;
 }
 
 /******************************************************************************/
 /*!
-	Frees mesh data in order to prevent memory leaks
+	Sends the state of every ship and object of a room to its players
 */
 /******************************************************************************/
-void GameStateAsteroidsUnload(void)
+unsigned int RoomSendSnapshot(Room& room, u64& bytes)
 {
-	// free all mesh data (shapes) of each object using "AEGfxTriFree"
-	for (unsigned long i = 0; i < GAME_OBJ_INST_NUM_MAX; i++)
+	// ========================================
+	// send new position information to clients
+	// ========================================
+	// Send Position Info to client
+
+	// the serialize phase of the last tick quantized the room for everyone
+	const QuantizeConfig& config = g_quantize;
+	const std::vector<SHIP_OBJ_INFO>& shipMsg = room.shipScratch;
+	const std::vector<EntityState>& ships = room.shipStateScratch;
+	const std::vector<EntityState>& objects = room.snapshotScratch;
+	const unsigned int shipBits = room.shipBits;
+	const bool interest = InterestEnabled(g_interest);
+
+	u32 sequence = room.snapshotSequence++;
+	u32 tick = SimClockGetTick();
+	unsigned int sent{};
+	room.packetScratch.resize(PROTOCOL_FRAGMENT_SIZE);
+	for (size_t i{0};i<room.clients.size();++i)
 	{
-		GameObjInst* pInst = sGameObjInstList + i;
+		// each player gets what changed since the newest snapshot it has, and
+		// everything when that one is too old
+		SnapshotHistory& history = room.snapshots[i];
+		const SnapshotFrame* baseline = SnapshotHistoryBaseline(history, history.acked, sequence);
+
+		// only what is around the player's ship, the objects that left its
+		// area go out as removals and the ones that came in as spawns
+		unsigned int ship = EntityRow(room.store, room.ships[i].objectID);
+		f32 shipX = room.store.posX[ship], shipY = room.store.posY[ship];
+		std::vector<f32>& priority = room.priorities[i];
+		const std::vector<EntityState>* relevant = &objects;
+		if (interest)
+		{
+			InterestSet& seen = room.interests[i];
+			InterestUpdate(seen, room.interestGrid, g_interest, shipX, shipY, room.interestScratch);
+			room.relevantScratch.resize(room.interestScratch.size());
+			for (size_t x{}; x < room.interestScratch.size(); ++x)
+				room.relevantScratch[x] = objects[room.interestScratch[x]];
+			relevant = &room.relevantScratch;
+			for (u32 slot : seen.left)
+				priority[slot] = 0.0f;
+		}
 
-		if (pInst->pObject != nullptr) {
-			AEGfxMeshFree(pInst->pObject->pMesh);
-			break;
+		// the baseline is never the frame added here, the history checks
+		SnapshotFrame& frame = SnapshotHistoryAdd(history, sequence, tick);
+		SnapshotDiff(config, baseline, *relevant, g_deltaTolerance, frame, room.removedScratch, room.changeScratch);
+
+		// an object that just came into view goes whole and ahead of every
+		// change, whatever the baseline still held of it from before it left
+		if (interest)
+		{
+			for (u32 slot : room.interests[i].entered)
+			{
+				auto bySlot = [](const EntityState& state, u32 value) { return state.slot < value; };
+				unsigned int at = static_cast<unsigned int>(
+					std::lower_bound(frame.objects.begin(), frame.objects.end(), slot, bySlot) - frame.objects.begin());
+				frame.objects[at] = *std::lower_bound(relevant->begin(), relevant->end(), slot, bySlot);
+
+				auto change = std::lower_bound(room.changeScratch.begin(), room.changeScratch.end(), at,
+					[](const SnapshotChange& c, unsigned int object) { return c.object < object; });
+				if (change != room.changeScratch.end() && change->object == at)
+					change->mask = SNAPSHOT_CHANGE_SPAWN;
+				else
+					room.changeScratch.insert(change, SnapshotChange{ at, SNAPSHOT_CHANGE_SPAWN });
+				priority[slot] = std::numeric_limits<f32>::infinity();
+			}
 		}
-	}	
-}
 
+		// every change that waits gains priority, more when it is near the
+		// player's ship, so a far bullet waits longer but never for good
+		for (u32 slot : room.removedScratch)
+			priority[slot] = 0.0f;
+		for (const SnapshotChange& change : room.changeScratch)
+		{
+			const EntityState& state = frame.objects[change.object];
+			unsigned int o = EntityRow(room.store, state.id);
+			f32 dx = room.store.posX[o] - shipX, dy = room.store.posY[o] - shipY;
+			priority[state.slot] += SNAPSHOT_TYPE_WEIGHT[state.type]
+				/ (1.0f + sqrtf(dx * dx + dy * dy) / SNAPSHOT_PRIORITY_DISTANCE);
+		}
+		std::stable_sort(room.changeScratch.begin(), room.changeScratch.end(),
+			[&frame, &priority](const SnapshotChange& a, const SnapshotChange& b) {
+				return priority[frame.objects[a.object].slot] > priority[frame.objects[b.object].slot]; });
+
+		// the ships always go, then the removals and the changes highest
+		// first until the fragments they make up would pass the budget. the
+		// rest wait for a later snapshot
+		SnapshotPacking packing;
+		SnapshotPackingInit(packing, shipBits);
+		unsigned int keepRemoved{}, keepChanges{};
+		bool full{};
+		for (; keepRemoved < room.removedScratch.size(); ++keepRemoved)
+		{
+			SnapshotPacking next = packing;
+			full = SnapshotPackingAdd(next, PROTOCOL_SLOT_BITS) > g_snapshotBudget;
+			if (full)
+				break;
+			packing = next;
+		}
+		for (; !full && keepChanges < room.changeScratch.size(); ++keepChanges)
+		{
+			const SnapshotChange& change = room.changeScratch[keepChanges];
+			SnapshotPacking next = packing;
+			full = SnapshotPackingAdd(next, SnapshotChangeBits(config, frame.objects[change.object], change.mask)) > g_snapshotBudget;
+			if (full)
+				break;
+			packing = next;
+			priority[frame.objects[change.object].slot] = 0.0f;
+		}
+		SnapshotDefer(config, baseline, frame, room.removedScratch, keepRemoved, room.changeScratch, keepChanges);
 
-void gameObjInstSet(int id, unsigned long type,
-	float scale,
-	AEVec2* pPos,
-	AEVec2* pVel,
-	float dir)
-{
+		SnapshotPlanFragments(config, frame, room.removedScratch, room.changeScratch, shipBits, room.fragmentScratch);
 
-	AEVec2 zero;
-	AEVec2Zero(&zero);
+		// every fragment fits one datagram and decodes alone
+		for (size_t f{}; f < room.fragmentScratch.size(); ++f)
+		{
+			PacketWriter writer;
+			PacketWriterInit(writer, room.packetScratch.data(), static_cast<unsigned int>(room.packetScratch.size()));
+			PacketWriteHeader(writer, PACKET_SNAPSHOT, tick, sequence);
+			PacketWriteU8(writer, static_cast<u8>(f));
+			PacketWriteU8(writer, static_cast<u8>(room.fragmentScratch.size()));
+			PacketWriteU16(writer, static_cast<u16>(f == 0 ? shipMsg.size() : 0));
+			PacketWriteU32(writer, baseline ? baseline->sequence : SNAPSHOT_NONE);
+
+			BitWriter bits;
+			BitWriterInit(bits, writer);
+			for (size_t s{}; f == 0 && s < shipMsg.size(); ++s)
+			{
+				int lives = shipMsg[s].live < 0 ? 0 : std::min(shipMsg[s].live, (1 << PROTOCOL_LIVES_BITS) - 1);
+				BitWrite(bits, shipMsg[s].dead ? 1 : 0, 1);
+				BitWrite(bits, static_cast<u32>(lives), PROTOCOL_LIVES_BITS);
+				BitWrite(bits, static_cast<u32>(shipMsg[s].score), 32);
+				SnapshotWriteEntity(bits, config, ships[s]);
+			}
+			SnapshotWriteFragment(bits, config, frame, room.removedScratch, room.changeScratch, room.fragmentScratch[f]);
+			BitWriterFlush(bits);
 
-	GameObjInst* pInst = sGameObjInstList + id;
+			int clientAddrLen = sizeof(room.clients[i]);
+			int errorCode = sendto(room.socket,
+				reinterpret_cast<const char*>(room.packetScratch.data()),
+				static_cast<int>(writer.size),
+				0,
+				reinterpret_cast<sockaddr*>(&room.clients[i]),
+				clientAddrLen);
 
-	// check if current instance is not used
-	// it is not used => use it to create the new instance
-	pInst->pObject = sGameObjList + type;
-	pInst->flag = FLAG_ACTIVE;
-	pInst->scale = scale;
-	pInst->posCurr = pPos ? *pPos : zero;
-	pInst->velCurr = pVel ? *pVel : zero;
-	pInst->dirCurr = dir;
+			if (errorCode == SOCKET_ERROR) {
+				std::cerr << "sendto() failed: " << WSAGetLastError() << std::endl;
+			}
+			else {
+				++sent;
+				bytes += writer.size;
+			}
+		}
+	}
 
-	if (pInst->pObject == nullptr)
-		std::cout << "ISNULL\n";
+	return sent;
 }
 
 /******************************************************************************/
 /*!
-	Creates game objects
+	Draws objects so that they can be seen on screen
 */
 /******************************************************************************/
-GameObjInst * gameObjInstCreate(unsigned long type, 
-							   float scale, 
-							   AEVec2 * pPos, 
-							   AEVec2 * pVel, 
-							   float dir)
+
+// TO REMOVE AS SERVER SHOULDNT DRAW
+void GameStateAsteroidsDraw(void)
 {
-	AEVec2 zero;
-	AEVec2Zero(&zero);
-	std::cout << type << "\n";
-	//AE_ASSERT_PARM(type < sGameObjNum);
 	
-	// loop through the object instance list to find a non-used object instance
-	for (unsigned long i = 0; i < GAME_OBJ_INST_NUM_MAX; i++)
-	{
-		GameObjInst * pInst = sGameObjInstList + i;
+}
 
-		// check if current instance is not used
-		if (pInst->flag == 0)
-		{
-			// it is not used => use it to create the new instance
-			pInst->pObject	= sGameObjList + type;
-			pInst->flag		= FLAG_ACTIVE;
-			pInst->scale	= scale;
-			pInst->posCurr	= pPos ? *pPos : zero;
-			pInst->velCurr	= pVel ? *pVel : zero;
-			pInst->dirCurr	= dir;
-			
-			// return the newly created instance
-			return pInst;
-		}
-	}
+/******************************************************************************/
+/*!
+	Frees gameObjects
+*/
+/******************************************************************************/
+void GameStateAsteroidsFree(void)
+{
+	// kill all object instances, with the rooms that held them
+	RoomDestroyAll();
 
-	// cannot find empty slot => return 0
-	return 0;
+	// a restart opens the shards again and may get another count
+	JobSystemExit();
 }
 
 /******************************************************************************/
 /*!
-	Destroys game ojects
+	Nothing to unload, the server has no meshes
 */
 /******************************************************************************/
-void gameObjInstDestroy(GameObjInst * pInst)
+void GameStateAsteroidsUnload(void)
 {
-	// if instance is destroyed before, just return
-	if (pInst->flag == 0)
-		return;
-
-	// zero out the flag
-	pInst->flag = 0;
-}
\ No newline at end of file
+}
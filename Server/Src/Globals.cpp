@@ -0,0 +1,38 @@
+/******************************************************************************/
+/*!
+\file			Globals.cpp
+\author
+\par
+\date
+\brief		This is the globals source file. It defines the global vars
+					Main.h declares, with their defaults. They live in the core
+					rather than next to main, so anything hosting the server's
+					modules, the bench included, links without Main.cpp.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "Main.h"
+#include "Shard.h"
+
+// ---------------------------------------------------------------------------
+// Globals
+float	  g_dt;
+double  g_appTime;
+std::string g_serverPort;
+unsigned int g_tickRate{ SIM_TICK_RATE_DEFAULT };
+unsigned int g_randomSeed{};
+SIM_KERNEL_ISA g_simKernelIsa{ SIM_KERNEL_AVX2 };
+BROADPHASE_TYPE g_broadphase{ BROADPHASE_GRID };
+unsigned int g_workerCount{ JOB_WORKER_COUNT_DEFAULT };
+
+unsigned int g_shardCount{ SHARD_NUM_DEFAULT };
+unsigned int g_inputDelay{ INPUT_BUFFER_DEPTH_DEFAULT };
+QuantizeConfig g_quantize{ 0.0f, 0.0f, 0.0f, 0.0f, 256.0f, 16, 10, 12, {}, 0, 0 };
+unsigned int g_deltaTolerance{ 2 };
+unsigned int g_snapshotBudget{ 4 * PROTOCOL_FRAGMENT_SIZE };
+InterestConfig g_interest{ 0.0f, 0.0f, 0.0f };
+unsigned int g_roomPlayers{ 2 };
@@ -0,0 +1,156 @@
+/******************************************************************************/
+/*!
+\file			InputBuffer.cpp
+\author
+\par
+\date
+\brief		This is the input buffer source file. The entries are a ring
+					indexed by client tick. The clocks of the client and the server
+					drift apart a little, so the buffer restarts when the client
+					falls far behind and drops ticks when it runs far ahead.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "InputBuffer.h"
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+static const u32 INPUT_TICK_NONE = 0xFFFFFFFF;
+
+// a client this many ticks past its delay behind the buffer restarted its
+// clock, or was away
+static const u32 INPUT_BUFFER_RESYNC = INPUT_BUFFER_SIZE / 8;
+
+/******************************************************************************/
+/*!
+	Forgets every buffered tick and waits to fill up again from tick
+*/
+/******************************************************************************/
+static void InputBufferRestart(InputBuffer& buffer, u32 tick)
+{
+	for (unsigned int i = 0; i < INPUT_BUFFER_SIZE; i++)
+		buffer.ticks[i] = INPUT_TICK_NONE;
+
+	buffer.receiving = true;
+	buffer.started = false;
+	buffer.next = tick;
+	buffer.newest = tick;
+	buffer.last = 0;
+	buffer.repeated = 0;
+	buffer.lateStreak = 0;
+}
+
+/******************************************************************************/
+/*!
+	Filling the buffer from the datagrams and taking one input per tick
+*/
+/******************************************************************************/
+void InputBufferInit(InputBuffer& buffer, unsigned int depth)
+{
+	InputBufferRestart(buffer, 0);
+
+	buffer.depth = depth < 1 ? 1 : (depth > INPUT_BUFFER_DEPTH_MAX ? INPUT_BUFFER_DEPTH_MAX : depth);
+	buffer.receiving = false;
+	buffer.late = buffer.missed = buffer.skipped = 0;
+}
+
+bool InputBufferAdd(InputBuffer& buffer, u32 tick, const InputKeys* keys, unsigned int count)
+{
+	if (!buffer.receiving)
+		InputBufferRestart(buffer, tick);
+
+	// ticks are compared as a difference, so the numbers may wrap
+	s32 ahead = static_cast<s32>(tick - buffer.next);
+	if (ahead < 0)
+	{
+		// one late datagram was held up on the way, depth of them in a row
+		// mean the client fell behind for good, its latency grew or its
+		// clock drifted, and nothing of it would ever be taken again
+		buffer.late++;
+		buffer.lateStreak++;
+		if (static_cast<u32>(-ahead) < buffer.depth + INPUT_BUFFER_RESYNC && buffer.lateStreak < buffer.depth)
+			return false;
+		InputBufferRestart(buffer, tick);
+	}
+	else if (static_cast<u32>(ahead) >= INPUT_BUFFER_SIZE)
+	{
+		InputBufferRestart(buffer, tick);
+	}
+
+	// every copy of a tick holds the same keys, only the first one is kept.
+	// the older ticks stop at the first one already taken
+	for (unsigned int i = 0; i < count; i++)
+	{
+		u32 at = tick - i;
+		if (static_cast<s32>(at - buffer.next) < 0)
+			break;
+
+		unsigned int entry = at & (INPUT_BUFFER_SIZE - 1);
+		if (buffer.ticks[entry] != at)
+		{
+			buffer.ticks[entry] = at;
+			buffer.keys[entry] = keys[i];
+		}
+	}
+
+	if (static_cast<s32>(tick - buffer.newest) > 0)
+		buffer.newest = tick;
+	buffer.lateStreak = 0;
+
+	return true;
+}
+
+InputKeys InputBufferTake(InputBuffer& buffer)
+{
+	if (!buffer.receiving)
+		return 0;
+
+	// hold back until depth ticks are in, late datagrams then still make it
+	u32 buffered = buffer.newest - buffer.next + 1;
+	if (!buffer.started)
+	{
+		if (buffered < buffer.depth)
+			return 0;
+		buffer.started = true;
+	}
+
+	// the client runs ahead, take the newest ticks so the delay stays put
+	if (static_cast<s32>(buffered) > static_cast<s32>(2 * buffer.depth))
+	{
+		u32 to = buffer.newest - buffer.depth + 1;
+		buffer.skipped += to - buffer.next;
+		buffer.next = to;
+	}
+
+	// a tick lost with all its copies, or not here yet, most likely had the
+	// keys of the one before. a player that went quiet lets go soon
+	InputKeys keys = 0;
+	unsigned int entry = buffer.next & (INPUT_BUFFER_SIZE - 1);
+	if (buffer.ticks[entry] == buffer.next)
+	{
+		keys = buffer.keys[entry];
+		buffer.ticks[entry] = INPUT_TICK_NONE;
+		buffer.last = keys;
+		buffer.repeated = 0;
+	}
+	else
+	{
+		if (static_cast<s32>(buffer.newest - buffer.next) > 0)
+			buffer.missed++;
+		if (buffer.repeated < INPUT_BUFFER_REPEAT_MAX)
+		{
+			keys = buffer.last & ~INPUT_KEY_SHOOT;
+			buffer.repeated++;
+		}
+	}
+
+	buffer.next++;
+	return keys;
+}
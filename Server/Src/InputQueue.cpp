@@ -0,0 +1,94 @@
+/******************************************************************************/
+/*!
+\file			InputQueue.cpp
+\author
+\par
+\date
+\brief		This is the input queue source file. Producers claim a cell by
+					moving the head with a compare and swap, then publish it through
+					the cell's sequence, so a slow producer only holds up the
+					consumer at its own cell and nobody ever waits on a lock.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "InputQueue.h"
+
+/******************************************************************************/
+/*!
+	Sizes the ring to a power of 2 and numbers every cell for its first lap
+*/
+/******************************************************************************/
+void InputQueueInit(InputQueue& queue, unsigned int capacity)
+{
+	u32 size = 1;
+	while (size < capacity)
+		size <<= 1;
+
+	queue.cells.reset(new InputQueueCell[size]);
+	for (u32 i = 0; i < size; i++)
+		queue.cells[i].sequence.store(i, std::memory_order_relaxed);
+
+	queue.mask = size - 1;
+	queue.head.store(0, std::memory_order_relaxed);
+	queue.tail = 0;
+	queue.dropped.store(0, std::memory_order_relaxed);
+}
+
+/******************************************************************************/
+/*!
+	Producers claim a cell by moving the head, the one consumer takes
+	them in order from the tail
+*/
+/******************************************************************************/
+bool InputQueuePush(InputQueue& queue, const InputCommand& command)
+{
+	u32 position = queue.head.load(std::memory_order_relaxed);
+	InputQueueCell* cell;
+
+	for (;;)
+	{
+		cell = &queue.cells[position & queue.mask];
+		u32 sequence = cell->sequence.load(std::memory_order_acquire);
+		s32 lag = static_cast<s32>(sequence - position);
+
+		if (lag == 0)
+		{
+			// free for this position, claim it unless another producer was faster
+			if (queue.head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (lag < 0)
+		{
+			// still holds the command from one lap ago
+			queue.dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else
+		{
+			position = queue.head.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->command = command;
+	cell->sequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputQueuePop(InputQueue& queue, InputCommand& command)
+{
+	InputQueueCell& cell = queue.cells[queue.tail & queue.mask];
+	u32 sequence = cell.sequence.load(std::memory_order_acquire);
+
+	// claimed but not written yet counts as empty, it is there next time
+	if (sequence != queue.tail + 1)
+		return false;
+
+	command = cell.command;
+	cell.sequence.store(queue.tail + queue.mask + 1, std::memory_order_release);
+	queue.tail++;
+	return true;
+}
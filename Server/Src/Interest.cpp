@@ -0,0 +1,157 @@
+/******************************************************************************/
+/*!
+\file			Interest.cpp
+\author
+\par
+\date
+\brief		This is the interest management source file. The grid is a
+					counting sort of the objects by cell, a query walks the cells
+					the area overlaps, wrapping around the world, and keeps the
+					objects whose wrapped distance to the centre is inside it. An
+					object wraps where the simulation wraps it, its own margin
+					past the bounds, one with an infinite margin never does.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "Interest.h"
+#include <algorithm>
+#include <cmath>
+
+/******************************************************************************/
+/*!
+	Grid
+*/
+/******************************************************************************/
+static unsigned int CellIndex(f32 value, f32 min, f32 cellSize, unsigned int count)
+{
+	f32 cell = std::floor((value - min) / cellSize);
+	if (!(cell > 0.0f))
+		return 0;
+	return cell >= static_cast<f32>(count) ? count - 1 : static_cast<unsigned int>(cell);
+}
+
+bool InterestEnabled(const InterestConfig& config)
+{
+	return config.radius > 0.0f || (config.halfWidth > 0.0f && config.halfHeight > 0.0f);
+}
+
+void InterestGridBuild(InterestGrid& grid, const SimBounds& bounds, f32 cellSize)
+{
+	grid.bounds = bounds;
+	grid.cellSize = cellSize;
+	grid.columns = std::max(1u, static_cast<unsigned int>(std::ceil((bounds.maxX - bounds.minX) / cellSize)));
+	grid.rows = std::max(1u, static_cast<unsigned int>(std::ceil((bounds.maxY - bounds.minY) / cellSize)));
+
+	unsigned int cells = grid.columns * grid.rows;
+	unsigned int count = static_cast<unsigned int>(grid.posX.size());
+	grid.cellStart.assign(cells + 1, 0);
+	grid.items.resize(count);
+
+	// count, sum up to the end of every cell, then fill every cell back to
+	// front so its start is left behind and the indices come out ascending
+	auto cellOf = [&grid](unsigned int i) {
+		return CellIndex(grid.posY[i], grid.bounds.minY, grid.cellSize, grid.rows) * grid.columns
+			+ CellIndex(grid.posX[i], grid.bounds.minX, grid.cellSize, grid.columns);
+	};
+	for (unsigned int i = 0; i < count; i++)
+		grid.cellStart[cellOf(i)]++;
+	for (unsigned int c = 1; c < cells; c++)
+		grid.cellStart[c] += grid.cellStart[c - 1];
+	for (unsigned int i = count; i-- > 0;)
+		grid.items[--grid.cellStart[cellOf(i)]] = i;
+	grid.cellStart[cells] = count;
+}
+
+/******************************************************************************/
+/*!
+	Queries
+*/
+/******************************************************************************/
+
+// first cell and how many the range min to max overlaps, every one when it
+// wraps all the way around
+static void CellRange(f32 min, f32 max, f32 worldMin, f32 cellSize, unsigned int count,
+	int& first, unsigned int& span)
+{
+	first = static_cast<int>(std::floor((min - worldMin) / cellSize));
+	int last = static_cast<int>(std::floor((max - worldMin) / cellSize));
+	span = last - first + 1 >= static_cast<int>(count) ? count : static_cast<unsigned int>(last - first + 1);
+	if (span == count)
+		first = 0;
+}
+
+// distance along one wrapping axis, an infinite period never wraps
+static f32 WrapDistance(f32 a, f32 b, f32 period)
+{
+	f32 d = std::fabs(a - b);
+	return d > period * 0.5f ? period - d : d;
+}
+
+void InterestUpdate(InterestSet& set, const InterestGrid& grid, const InterestConfig& config,
+	f32 x, f32 y, std::vector<unsigned int>& found)
+{
+	const std::vector<u32>& slots = grid.slots;
+	found.clear();
+
+	f32 width = grid.bounds.maxX - grid.bounds.minX;
+	f32 height = grid.bounds.maxY - grid.bounds.minY;
+	f32 extentX = (config.radius > 0.0f ? config.radius : config.halfWidth) * INTEREST_HYSTERESIS;
+	f32 extentY = (config.radius > 0.0f ? config.radius : config.halfHeight) * INTEREST_HYSTERESIS;
+
+	int column, row;
+	unsigned int columns, rows;
+	CellRange(x - extentX, x + extentX, grid.bounds.minX, grid.cellSize, grid.columns, column, columns);
+	CellRange(y - extentY, y + extentY, grid.bounds.minY, grid.cellSize, grid.rows, row, rows);
+
+	for (unsigned int r = 0; r < rows; r++)
+	{
+		unsigned int cellY = static_cast<unsigned int>(((row + static_cast<int>(r)) % static_cast<int>(grid.rows)
+			+ static_cast<int>(grid.rows)) % static_cast<int>(grid.rows));
+		for (unsigned int c = 0; c < columns; c++)
+		{
+			unsigned int cellX = static_cast<unsigned int>(((column + static_cast<int>(c)) % static_cast<int>(grid.columns)
+				+ static_cast<int>(grid.columns)) % static_cast<int>(grid.columns));
+			unsigned int cell = cellY * grid.columns + cellX;
+
+			for (unsigned int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++)
+			{
+				unsigned int i = grid.items[k];
+				f32 dx = WrapDistance(grid.posX[i], x, width + 2.0f * grid.margins[i]);
+				f32 dy = WrapDistance(grid.posY[i], y, height + 2.0f * grid.margins[i]);
+
+				// what is already seen gets a little more room before it goes
+				f32 scale = std::binary_search(set.slots.begin(), set.slots.end(), slots[i]) ? INTEREST_HYSTERESIS : 1.0f;
+				bool inside = config.radius > 0.0f
+					? dx * dx + dy * dy <= config.radius * config.radius * scale * scale
+					: dx <= config.halfWidth * scale && dy <= config.halfHeight * scale;
+				if (inside)
+					found.push_back(i);
+			}
+		}
+	}
+	std::sort(found.begin(), found.end());
+
+	// both lists ascend by slot, one walk finds what came and went
+	set.entered.clear();
+	set.left.clear();
+	size_t s = 0;
+	for (unsigned int i : found)
+	{
+		u32 slot = slots[i];
+		while (s < set.slots.size() && set.slots[s] < slot)
+			set.left.push_back(set.slots[s++]);
+		if (s < set.slots.size() && set.slots[s] == slot)
+			s++;
+		else
+			set.entered.push_back(slot);
+	}
+	set.left.insert(set.left.end(), set.slots.begin() + s, set.slots.end());
+
+	set.slots.resize(found.size());
+	for (size_t k = 0; k < found.size(); k++)
+		set.slots[k] = slots[found[k]];
+}
@@ -0,0 +1,301 @@
+/******************************************************************************/
+/*!
+\file			JobSystem.cpp
+\author
+\par
+\date
+\brief		This is the job system source file. Every thread owns a queue:
+					it pushes and pops at the back, so it keeps working on what it
+					just made ready while that is still in cache, and other threads
+					steal from the front. Queue 0 belongs to the thread that runs
+					the graphs, without workers every thread runs its graphs alone.
+					Workers with nothing to do sleep until a job is queued.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "JobSystem.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+struct JobQueue
+{
+	std::mutex				mutex;
+	std::deque<Job*>	jobs;
+};
+
+/******************************************************************************/
+/*!
+	Static Variables
+*/
+/******************************************************************************/
+static std::vector<std::thread>			sWorkers;
+static std::unique_ptr<JobQueue[]>	sQueues;						// one per worker, plus the caller's
+static unsigned int									sQueueCount;
+
+static std::mutex										sSleepMutex;
+static std::condition_variable			sWake;							// a job was queued, or the exit
+static std::atomic<unsigned int>		sQueued;						// jobs sitting in any queue
+static bool													sExit;
+
+static thread_local unsigned int		tQueue = 0;					// queue of the running thread
+
+/******************************************************************************/
+/*!
+	Queues a job that is ready to run on the running thread's queue
+*/
+/******************************************************************************/
+static void JobPush(Job* job)
+{
+	JobQueue& q = sQueues[tQueue];
+	{
+		std::lock_guard<std::mutex> lock(q.mutex);
+		q.jobs.push_back(job);
+	}
+	sQueued.fetch_add(1);
+
+	if (!sWorkers.empty())
+	{
+		// taking the lock makes sure a worker about to sleep sees the job first
+		{ std::lock_guard<std::mutex> lock(sSleepMutex); }
+		sWake.notify_one();
+	}
+}
+
+/******************************************************************************/
+/*!
+	Newest job of the own queue, or else the oldest of someone else's,
+	nullptr when every queue is empty
+*/
+/******************************************************************************/
+static Job* JobTake()
+{
+	{
+		JobQueue& q = sQueues[tQueue];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.jobs.empty())
+		{
+			Job* job = q.jobs.back();
+			q.jobs.pop_back();
+			sQueued.fetch_sub(1);
+			return job;
+		}
+	}
+
+	for (unsigned int i = 1; i < sQueueCount; i++)
+	{
+		JobQueue& q = sQueues[(tQueue + i) % sQueueCount];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.jobs.empty())
+		{
+			Job* job = q.jobs.front();
+			q.jobs.pop_front();
+			sQueued.fetch_sub(1);
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+/******************************************************************************/
+/*!
+	Runs a job, then queues whatever it was the last thing holding up
+*/
+/******************************************************************************/
+static void JobExecute(Job* job)
+{
+	job->function();
+
+	for (Job* next : job->next)
+	{
+		if (next->waitingOn.fetch_sub(1) == 1)
+			JobPush(next);
+	}
+
+	// the graph may be gone as soon as this reaches 0, touch nothing after it
+	job->graph->unfinished.fetch_sub(1);
+}
+
+static void JobWorkerThread(unsigned int queue)
+{
+	tQueue = queue;
+
+	for (;;)
+	{
+		Job* job = JobTake();
+		if (job)
+		{
+			JobExecute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sSleepMutex);
+		sWake.wait(lock, [] { return sExit || sQueued.load() > 0; });
+		if (sExit)
+			return;
+	}
+}
+
+/******************************************************************************/
+/*!
+	Starting and stopping the workers
+*/
+/******************************************************************************/
+void JobSystemInit(unsigned int workerCount)
+{
+	if (workerCount > JOB_WORKER_COUNT_MAX)
+		workerCount = JOB_WORKER_COUNT_MAX;
+
+	sExit = false;
+	sQueued = 0;
+	sQueueCount = workerCount + 1;
+	sQueues.reset(new JobQueue[sQueueCount]);
+
+	for (unsigned int i = 1; i <= workerCount; i++)
+		sWorkers.emplace_back(JobWorkerThread, i);
+}
+
+void JobSystemExit()
+{
+	{
+		std::lock_guard<std::mutex> lock(sSleepMutex);
+		sExit = true;
+	}
+	sWake.notify_all();
+
+	for (std::thread& t : sWorkers)
+		t.join();
+	sWorkers.clear();
+
+	sQueues.reset();
+	sQueueCount = 0;
+}
+
+unsigned int JobSystemGetWorkerCount()
+{
+	return static_cast<unsigned int>(sWorkers.size());
+}
+
+/******************************************************************************/
+/*!
+	Building a graph
+*/
+/******************************************************************************/
+Job* JobGraphAdd(JobGraph& graph, JobFunction function)
+{
+	graph.jobs.emplace_back();
+
+	Job* job = &graph.jobs.back();
+	job->function = std::move(function);
+	job->graph = &graph;
+	job->dependencyCount = 0;
+
+	return job;
+}
+
+void JobGraphDepend(Job* job, Job* before)
+{
+	before->next.push_back(job);
+	job->dependencyCount++;
+}
+
+void JobGraphClear(JobGraph& graph)
+{
+	graph.jobs.clear();
+}
+
+/******************************************************************************/
+/*!
+	Running a graph, or a range split into one
+*/
+/******************************************************************************/
+void JobGraphRun(JobGraph& graph)
+{
+	if (graph.jobs.empty())
+		return;
+
+	// nobody to share with, run it in order here without touching the queues,
+	// so threads running graphs of their own never pick up each other's jobs
+	if (sWorkers.empty())
+	{
+		for (Job& job : graph.jobs)
+			job.waitingOn = job.dependencyCount;
+
+		std::vector<Job*> ready;
+		for (Job& job : graph.jobs)
+		{
+			if (job.dependencyCount == 0)
+				ready.push_back(&job);
+		}
+
+		while (!ready.empty())
+		{
+			Job* job = ready.back();
+			ready.pop_back();
+
+			job->function();
+			for (Job* next : job->next)
+			{
+				if (next->waitingOn.fetch_sub(1) == 1)
+					ready.push_back(next);
+			}
+		}
+		return;
+	}
+
+	// every count is set before the first job can finish
+	graph.unfinished = static_cast<unsigned int>(graph.jobs.size());
+	for (Job& job : graph.jobs)
+		job.waitingOn = job.dependencyCount;
+
+	for (Job& job : graph.jobs)
+	{
+		if (job.dependencyCount == 0)
+			JobPush(&job);
+	}
+
+	// help until the graph is done, this may run jobs of other graphs too
+	while (graph.unfinished.load() > 0)
+	{
+		Job* job = JobTake();
+		if (job)
+			JobExecute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobParallelFor(unsigned int count, unsigned int grain, const JobRangeFunction& function)
+{
+	if (count == 0)
+		return;
+	if (grain == 0)
+		grain = 1;
+
+	// one range, or nobody to share it with
+	if (count <= grain || sWorkers.empty())
+	{
+		function(0, count);
+		return;
+	}
+
+	JobGraph graph;
+	for (unsigned int begin = 0; begin < count; begin += grain)
+	{
+		unsigned int end = count - begin < grain ? count : begin + grain;
+		JobGraphAdd(graph, [&function, begin, end] { function(begin, end); });
+	}
+
+	JobGraphRun(graph);
+}
@@ -12,19 +12,18 @@ prior written consent of DigiPen Institute of Technology is prohibited.
  */
  /******************************************************************************/
 
-#include "main.h"
+#include "Main.h"
+#include "Room.h"
+#include "Shard.h"
+#include <stdexcept>
 
-// ---------------------------------------------------------------------------
-// Globals
-float	  g_dt;
-double  g_appTime;
+// size of the world, same as the window the server used to open
+const unsigned int SERVER_WIN_WIDTH = 800;
+const unsigned int SERVER_WIN_HEIGHT = 600;
+const unsigned int SERVER_FRAME_RATE = 60;
 
-SOCKET listenerSocket;
-std::vector<sockaddr_in> ClientSocket;
-std::mutex GAME_OBJECT_LIST_MUTEX;
-
-void ReceiveClientMessages(SOCKET clientSocket);
 
+#ifndef SERVER_HEADLESS
 /******************************************************************************/
 /*!
 	Starting point of the application
@@ -40,8 +39,11 @@ int WINAPI WinMain(_In_ HINSTANCE instanceH, _In_opt_ HINSTANCE prevInstanceH, _
 		_CrtSetDbgFlag( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF );
 	#endif
 
+	if (!ParseServerArgs(__argc, __argv))
+		return 1;
+
 	// Initialize the system
-	AESysInit (instanceH, show, 800, 600, 1, 60, false, NULL);
+	AESysInit (instanceH, show, SERVER_WIN_WIDTH, SERVER_WIN_HEIGHT, 1, SERVER_FRAME_RATE, false, NULL);
 
 	if (!freopen("CONIN$", "r", stdin)) {
 		return 1;
@@ -61,12 +63,173 @@ int WINAPI WinMain(_In_ HINSTANCE instanceH, _In_opt_ HINSTANCE prevInstanceH, _
 	//set background color
 	AEGfxSetBackgroundColor(0.0f, 0.0f, 0.0f);
 
+	PlatformInit(SERVER_WIN_WIDTH, SERVER_WIN_HEIGHT, SERVER_FRAME_RATE);
+
+	int ret{ RunServer() };
+
+	// free the system
+	AESysExit();
+
+	return ret;
+}
+#else
+/******************************************************************************/
+/*!
+	Starting point of the headless server, no window and no render loop
+*/
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	if (!ParseServerArgs(argc, argv))
+		return 1;
+
+	// nothing is drawn, so wake up exactly once per simulation tick
+	PlatformInit(SERVER_WIN_WIDTH, SERVER_WIN_HEIGHT, g_tickRate);
+
+	return RunServer();
+}
+#endif
+
+// the optional command line arguments
+static const char* const SERVER_USAGE =
+	"Arguments:\n"
+	"  -port <number>           port to listen on, asked on the console when missing\n"
+	"  -tickrate <hz>           simulation ticks per second (30, 60, 120...)\n"
+	"  -seed <number>           seed of the simulation random numbers, random when 0\n"
+	"  -simd <isa>              widest kernel to use: scalar, sse2 or avx2\n"
+	"  -broadphase <b>          collision broadphase: grid, sap or brute\n"
+	"  -workers <n>             job threads besides the game loop, 0 for none\n"
+	"  -shards <n>              threads with their own core, socket and rooms\n"
+	"  -players <n>             players a room takes, 1 to 8, 2 when missing\n"
+	"  -inputdelay <n>          ticks of input held back per player against jitter\n"
+	"  -posbits <n>             bits of each snapshot position component, 1 to 24\n"
+	"  -anglebits <n>           bits of each snapshot direction\n"
+	"  -velbits <n>             bits of each snapshot velocity component\n"
+	"  -deltatolerance <n>      position steps an object may stray from where its\n"
+	"                           velocity takes it before it is sent again\n"
+	"  -snapshotbudget <bytes>  most a snapshot to one player may take, only\n"
+	"                           the ships, which always go, can pass it\n"
+	"  -interestradius <r>      players are only sent the objects this close to\n"
+	"                           their ship, the whole world when missing\n"
+	"  -interestview <w> <h>    same with a view rectangle around the ship\n";
+
+/******************************************************************************/
+/*!
+	A count from the command line. stoul takes "-1" and wraps it to the
+	largest value, so the sign is turned away here
+*/
+/******************************************************************************/
+static unsigned long ParseCount(const char* value)
+{
+	std::string text{ value };
+	size_t first{ text.find_first_not_of(" \t\n\v\f\r") };
+	if (first != std::string::npos && text[first] == '-')
+		throw std::invalid_argument(text);
+	return std::stoul(text);
+}
+
+/******************************************************************************/
+/*!
+	Reads the optional command line arguments, see SERVER_USAGE. Prints the
+	usage and returns false on an unknown argument, a value that is not a
+	number, a negative count or a name that is not one of the listed ones.
+	Worker, shard and player counts are cut to their range
+*/
+/******************************************************************************/
+bool ParseServerArgs(int argc, char* argv[])
+{
+	for (int i{ 1 }; i < argc; ++i) {
+		std::string arg{ argv[i] };
+
+		try {
+			if (arg == "-port" && i + 1 < argc) {
+				g_serverPort = argv[++i];
+			}
+			else if (arg == "-tickrate" && i + 1 < argc) {
+				g_tickRate = static_cast<unsigned int>(ParseCount(argv[++i]));
+			}
+			else if (arg == "-seed" && i + 1 < argc) {
+				g_randomSeed = static_cast<unsigned int>(ParseCount(argv[++i]));
+			}
+			else if (arg == "-simd" && i + 1 < argc) {
+				std::string isa{ argv[++i] };
+				if (isa != "scalar" && isa != "sse2" && isa != "avx2")
+					throw std::invalid_argument(isa);
+				g_simKernelIsa = isa == "scalar" ? SIM_KERNEL_SCALAR
+					: isa == "sse2" ? SIM_KERNEL_SSE2 : SIM_KERNEL_AVX2;
+			}
+			else if (arg == "-broadphase" && i + 1 < argc) {
+				std::string broadphase{ argv[++i] };
+				if (broadphase != "grid" && broadphase != "sap" && broadphase != "brute")
+					throw std::invalid_argument(broadphase);
+				g_broadphase = broadphase == "brute" ? BROADPHASE_BRUTE
+					: broadphase == "sap" ? BROADPHASE_SAP : BROADPHASE_GRID;
+			}
+			else if (arg == "-workers" && i + 1 < argc) {
+				unsigned long workers{ ParseCount(argv[++i]) };
+				g_workerCount = static_cast<unsigned int>(workers > JOB_WORKER_COUNT_MAX ? JOB_WORKER_COUNT_MAX : workers);
+			}
+			else if (arg == "-shards" && i + 1 < argc) {
+				unsigned long shards{ ParseCount(argv[++i]) };
+				g_shardCount = static_cast<unsigned int>(shards > SHARD_NUM_MAX ? SHARD_NUM_MAX : shards);
+			}
+			else if (arg == "-players" && i + 1 < argc) {
+				unsigned long players{ ParseCount(argv[++i]) };
+				g_roomPlayers = static_cast<unsigned int>(players < 1 ? 1 : (players > MAX_CLIENTS ? MAX_CLIENTS : players));
+			}
+			else if (arg == "-inputdelay" && i + 1 < argc) {
+				g_inputDelay = static_cast<unsigned int>(ParseCount(argv[++i]));
+			}
+			else if ((arg == "-posbits" || arg == "-anglebits" || arg == "-velbits") && i + 1 < argc) {
+				unsigned long bits{ ParseCount(argv[++i]) };
+				u8 clamped{ static_cast<u8>(bits < 1 ? 1 : (bits > 24 ? 24 : bits)) };
+				(arg == "-posbits" ? g_quantize.positionBits
+					: arg == "-anglebits" ? g_quantize.angleBits : g_quantize.velocityBits) = clamped;
+			}
+			else if (arg == "-deltatolerance" && i + 1 < argc) {
+				g_deltaTolerance = static_cast<unsigned int>(ParseCount(argv[++i]));
+			}
+			else if (arg == "-snapshotbudget" && i + 1 < argc) {
+				g_snapshotBudget = static_cast<unsigned int>(ParseCount(argv[++i]));
+			}
+			else if (arg == "-interestradius" && i + 1 < argc) {
+				g_interest.radius = std::stof(argv[++i]);
+			}
+			else if (arg == "-interestview" && i + 2 < argc) {
+				g_interest.halfWidth = std::stof(argv[++i]) / 2.0f;
+				g_interest.halfHeight = std::stof(argv[++i]) / 2.0f;
+			}
+			else {
+				std::cerr << "Unknown argument: " << arg << std::endl << SERVER_USAGE;
+				return false;
+			}
+		}
+		catch (const std::logic_error&) {
+			// std::invalid_argument and std::out_of_range from stoul and stof,
+			// and std::invalid_argument for an unknown name
+			std::cerr << "Bad value for " << arg << ": " << argv[i] << std::endl << SERVER_USAGE;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/******************************************************************************/
+/*!
+	Game state loop shared by the windowed and the headless server
+*/
+/******************************************************************************/
+int RunServer()
+{
 	GameStateMgrInit(GS_ASTEROIDS);
 
 	while(gGameStateCurr != GS_QUIT)
 	{
+#ifndef SERVER_HEADLESS
 		// reset the system modules
 		AESysReset();
+#endif
 
 		// If not restarting, load the gamestate
 		if(gGameStateCurr != GS_RESTART)
@@ -87,29 +250,30 @@ int WINAPI WinMain(_In_ HINSTANCE instanceH, _In_opt_ HINSTANCE prevInstanceH, _
 		// Initialize the gamestate
 		GameStateInit();
 
-		// Create recieve thread
-		std::thread receiveThread(ReceiveClientMessages, listenerSocket);
+		// every shard receives, simulates and sends on its own thread
+		ShardsStart();
 
 		while(gGameStateCurr == gGameStateNext)
 		{
-			AESysFrameStart();
-
-			AEInputUpdate();
+			PlatformFrameStart();
 
 			GameStateUpdate();
 
 			GameStateDraw();
-			
-			AESysFrameEnd();
+
+			PlatformFrameEnd();
 
 			// check if forcing the application to quit
-			if ((AESysDoesWindowExist() == false) || AEInputCheckTriggered(AEVK_ESCAPE))
+			if (PlatformQuitRequested())
 				gGameStateNext = GS_QUIT;
 
-			g_dt = (f32)AEFrameRateControllerGetFrameTime();
+			g_dt = (f32)PlatformGetFrameTime();
 			g_appTime += g_dt;
 		}
-		
+
+		// the rooms go away with the game state, stop the shards using them first
+		ShardsStop();
+
 		GameStateFree();
 
 		if(gGameStateNext != GS_RESTART)
@@ -117,34 +281,27 @@ int WINAPI WinMain(_In_ HINSTANCE instanceH, _In_opt_ HINSTANCE prevInstanceH, _
 
 		gGameStatePrev = gGameStateCurr;
 		gGameStateCurr = gGameStateNext;
-		if (receiveThread.joinable()) {
-			receiveThread.join();
-		}
-	}
 
-	// free the system
-	AESysExit();
+		PlatformNetExit();
+	}
 
 	return 0;
 }
 
 int WinsockServerSetup() {
+#ifndef SERVER_HEADLESS
 	HWND hwndConsole = GetConsoleWindow();
 	SetForegroundWindow(hwndConsole);
+#endif
 
-	std::string portString{};
-	std::cout << "Server Port Number: ";
-	std::cin >> portString;
-	std::cout << std::endl;
-	//double interval{};
-	//std::cout << "Server packet interval: ";
-	//std::cin >> interval;
-	//std::cout << std::endl;
-	//PACKAGE_INTERVAL = interval;
-
+	std::string portString{ g_serverPort };
+	if (portString.empty()) {
+		std::cout << "Server Port Number: ";
+		std::cin >> portString;
+		std::cout << std::endl;
+	}
 	// Start Winsock
-	WSADATA wsaData{};
-	int errorCode = WSAStartup(MAKEWORD(2, 2), &wsaData);
+	int errorCode = PlatformNetInit();
 	if (errorCode != NO_ERROR) {
 		std::cerr << "WSAStartup() failed." << std::endl;
 		return errorCode;
@@ -156,15 +313,21 @@ int WinsockServerSetup() {
 	hints.ai_family = AF_INET;
 	hints.ai_socktype = SOCK_DGRAM;
 	hints.ai_protocol = IPPROTO_UDP;
+
+	addrinfo* info = nullptr;
+#ifndef SERVER_HEADLESS
 	constexpr int HOSTBUFFERSIZE = 16;
 	char hostBuffer[HOSTBUFFERSIZE];
 	gethostname(hostBuffer, HOSTBUFFERSIZE);
-
-	addrinfo* info = nullptr;
 	errorCode = getaddrinfo(hostBuffer, portString.c_str(), &hints, &info);
+#else
+	// a dedicated host listens on every interface
+	hints.ai_flags = AI_PASSIVE;
+	errorCode = getaddrinfo(nullptr, portString.c_str(), &hints, &info);
+#endif
 	if ((errorCode) || (info == nullptr)) {
 		std::cerr << "getaddrinfo() failed." << std::endl;
-		WSACleanup();
+		PlatformNetExit();
 		return errorCode;
 	}
 
@@ -175,140 +338,16 @@ int WinsockServerSetup() {
 	std::cout << "Server Port Number: " << portString << "\n";
 	std::cout << std::endl;
 
-	// Create and Bind Socket for listening
-	listenerSocket = socket(
-		info->ai_family,
-		info->ai_socktype,
-		info->ai_protocol);
-	if (listenerSocket == INVALID_SOCKET) {
-		std::cerr << "socket() failed." << std::endl;
-		freeaddrinfo(info);
-		WSACleanup();
-		return 1;
-	}
-
-	errorCode = bind(
-		listenerSocket,
-		info->ai_addr,
-		static_cast<int>(info->ai_addrlen));
-	if (errorCode != NO_ERROR) {
-		std::cerr << "bind() failed." << std::endl;
-		closesocket(listenerSocket);
-		listenerSocket = INVALID_SOCKET;
-	}
-
+	// Create and Bind a Socket for listening per shard
+	errorCode = ShardsOpen(g_shardCount, info);
 	freeaddrinfo(info);
 
-	if (listenerSocket == INVALID_SOCKET) {
-		std::cerr << "bind() failed." << std::endl;
-		WSACleanup();
-		return 2;
-	}
-
-	// Receive datagrams
-	char buffer[1024];
-	sockaddr_in clientAddr;
-	int clientAddrLen = sizeof(clientAddr);
-
-	int currClient{};
-	while (currClient < MAX_CLIENTS) {
-		std::cout << "Waiting for Client\n";
-		int bytesRead = recvfrom(listenerSocket, buffer, sizeof(buffer), 0,
-			reinterpret_cast<sockaddr*>(&clientAddr), &clientAddrLen);
-		if (bytesRead == SOCKET_ERROR) {
-			std::cerr << "recvfrom() failed: " << WSAGetLastError() << std::endl;
-			break;
-		}
-		buffer[bytesRead] = '\0';
-
-		std::cout << "Received datagram: " << buffer << std::endl;
-
-		
-
-		// Send Ship ID to client
-		SERVER_INITIAL_MESSAGE_FORMAT toSend{};
-		toSend.ShipID = AddNewShip();
-		std::cout << "CREATED SHIP: " << toSend.ShipID << "\n";
-
-		int errorCode = sendto(listenerSocket,
-			reinterpret_cast<const char*>(&toSend),
-			sizeof(SERVER_INITIAL_MESSAGE_FORMAT),
-			0,
-			reinterpret_cast<sockaddr*>(&clientAddr), 
-			clientAddrLen);
-
-		ClientSocket.push_back(clientAddr);
-		currClient++;
-	
-		std::cout << "Added Client\n";
+	if (errorCode) {
+		PlatformNetExit();
+		return errorCode;
 	}
+	std::cout << "Shards: " << ShardGetCount() << "\n";
 
+	// players join from the shard threads, each one into a room
 	return 0;
 }
-
-void ReceiveClientMessages(SOCKET clientSocket) {
-	const float					SHIP_ACCEL_FORWARD = 60.0f;			// ship forward acceleration (in m/s^2)
-	const float					SHIP_ACCEL_BACKWARD = 60.0f;		// ship backward acceleration (in m/s^2)
-	const float					SHIP_ROT_SPEED = (2.0f * PI);		// ship rotation speed (degree/second)
-
-	while (true) {
-		sockaddr_in clientAddr;
-		int clientAddrLen = sizeof(clientAddr);
-		char buffer[sizeof(CLIENT_MESSAGE_FORMAT)];
-
-		int bytesRead = recvfrom(clientSocket, buffer, sizeof(buffer), 0,
-			reinterpret_cast<sockaddr*>(&clientAddr), &clientAddrLen);
-		if (bytesRead == SOCKET_ERROR) {
-			std::cerr << "recvfrom() failed: " << WSAGetLastError() << std::endl;
-		}
-
-		CLIENT_MESSAGE_FORMAT recv{ *reinterpret_cast<CLIENT_MESSAGE_FORMAT*>(buffer) };
-
-		std::lock_guard<std::mutex> lock(GAME_OBJECT_LIST_MUTEX);
-		GameObjInst& currShip{ sGameObjInstList[recv.ShipID] };
-
-		if (recv.MessageType == static_cast<int>(MESSAGE_TYPE::TYPE_MOVEMENT_UP)) {
-			AEVec2 accel;
-			AEVec2Set(&accel, static_cast<f32>(cosf(currShip.dirCurr)),
-				static_cast<f32>(sinf(currShip.dirCurr))); //normalized acceleration vector
-
-			if ((currShip.flag & FLAG_ACTIVE) == 0)
-				std::cout << "SHIP NULL: " << recv.ShipID << "\n";
-
-			accel = { accel.x * SHIP_ACCEL_FORWARD, accel.y * SHIP_ACCEL_FORWARD }; //full acceleration vector
-			currShip.velCurr = { accel.x * static_cast<f32>(AEFrameRateControllerGetFrameTime()) + currShip.velCurr.x,
-				accel.y * static_cast<f32>(AEFrameRateControllerGetFrameTime()) + currShip.velCurr.y };
-			currShip.velCurr = { currShip.velCurr.x * static_cast<f32>(0.99), currShip.velCurr.y * static_cast<f32>(0.99) };
-		}
-
-		if (recv.MessageType == static_cast<int>(MESSAGE_TYPE::TYPE_MOVEMENT_DOWN)) {
-			AEVec2 accel;
-			AEVec2Set(&accel, static_cast<f32>(-cosf(currShip.dirCurr)), 
-				static_cast<f32>(-sinf(currShip.dirCurr))); //normalized acceleration vector
-			accel = { accel.x * SHIP_ACCEL_FORWARD, accel.y * SHIP_ACCEL_FORWARD }; //full acceleration vector
-			currShip.velCurr = { accel.x * static_cast<f32>(AEFrameRateControllerGetFrameTime()) + currShip.velCurr.x,
-				accel.y * static_cast<f32>(AEFrameRateControllerGetFrameTime()) + currShip.velCurr.y };
-			currShip.velCurr = { currShip.velCurr.x * static_cast<f32>(0.99), currShip.velCurr.y * static_cast<f32>(0.99) };
-		}
-
-		if (recv.MessageType == static_cast<int>(MESSAGE_TYPE::TYPE_MOVEMENT_LEFT)) {
-			currShip.dirCurr += SHIP_ROT_SPEED * (float)(AEFrameRateControllerGetFrameTime());
-			currShip.dirCurr = AEWrap(currShip.dirCurr, -PI, PI);
-		}
-
-		if (recv.MessageType == static_cast<int>(MESSAGE_TYPE::TYPE_MOVEMENT_RIGHT)) {
-			currShip.dirCurr -= SHIP_ROT_SPEED * (float)(AEFrameRateControllerGetFrameTime());
-			currShip.dirCurr = AEWrap(currShip.dirCurr, -PI, PI);
-		}
-
-		if (recv.MessageType == static_cast<int>(MESSAGE_TYPE::TYPE_SHOOT)) {
-			AEVec2 vel;
-			AEVec2Set(&vel, cosf(currShip.dirCurr), sinf(currShip.dirCurr));
-			vel.x = vel.x * BULLET_SPEED;
-			vel.y = vel.y * BULLET_SPEED;
-
-			// Create an instance
-			FireBullet(recv.ShipID, currShip.posCurr, vel);
-		}
-	}
-}
\ No newline at end of file
@@ -0,0 +1,119 @@
+/******************************************************************************/
+/*!
+\file			Narrowphase.cpp
+\author
+\par
+\date
+\brief		This is the collision narrowphase source file. The pairs of one
+					asteroid are packed into a batch and tested in one call, runs of
+					asteroids are spread over the job system, each run into its own
+					event list.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "Narrowphase.h"
+#include "Room.h"
+#include "JobSystem.h"
+#include <algorithm>
+
+/******************************************************************************/
+/*!
+	Runs the narrowphase on the pairs first to last - 1, all of one asteroid,
+	and adds the hits to events
+*/
+/******************************************************************************/
+static void DetectAsteroid(const Room& room, unsigned int first, unsigned int last, f32 dt,
+													 CollisionBatch& batch, std::vector<CollisionEvent>& events)
+{
+	const EntityStore& e = room.store;
+	const std::vector<BroadphasePair>& pairs = room.pairScratch;
+
+	unsigned int i = pairs[first].query;
+	AABB		asteroidBox{ { e.minX[i], e.minY[i] }, { e.maxX[i], e.maxY[i] } };
+	AEVec2	asteroidVel{ e.velX[i], e.velY[i] };
+
+	// the candidate is moved back by the wrap shift instead of moving the asteroid
+	// once per pair, that keeps the asteroid the same for the whole batch
+	batch.Resize(last - first);
+	for (unsigned int p = first; p < last; p++)
+	{
+		const BroadphasePair& pair = pairs[p];
+		unsigned int x = pair.target;
+		unsigned int c = p - first;
+
+		batch.minX[c] = e.minX[x] - pair.offset.x;
+		batch.minY[c] = e.minY[x] - pair.offset.y;
+		batch.maxX[c] = e.maxX[x] - pair.offset.x;
+		batch.maxY[c] = e.maxY[x] - pair.offset.y;
+		batch.velX[c] = e.velX[x];
+		batch.velY[c] = e.velY[x];
+	}
+
+	unsigned int hitCount = CollisionIntersection_RectRectBatch(asteroidBox, asteroidVel,
+		batch.minX.data(), batch.minY.data(), batch.maxX.data(), batch.maxY.data(),
+		batch.velX.data(), batch.velY.data(), last - first, dt, batch.hits.data());
+
+	for (unsigned int p = first; p < last && hitCount > 0; p++)
+	{
+		if (!batch.hits[p - first])
+			continue;
+
+		// a pair seen across a wrap edge and straight on is still one event
+		unsigned int x = pairs[p].target;
+		if (p > first && pairs[p - 1].target == x && batch.hits[p - 1 - first])
+			continue;
+
+		events.push_back(CollisionEvent{ i, x });
+	}
+}
+
+/******************************************************************************/
+/*!
+	Detection stage: runs the narrowphase on the broadphase pairs and records
+	every hit as an event. Nothing in the world is changed here, so the
+	asteroids are split into runs that the job system tests side by side,
+	each run into its own event list. The lists are joined in run order, which
+	gives the same events in the same order as testing on one thread
+*/
+/******************************************************************************/
+void DetectCollisions(Room& room, f32 dt)
+{
+	const std::vector<BroadphasePair>& pairs = room.pairScratch;
+	std::vector<unsigned int>& groups = room.groupScratch;
+	std::vector<DetectTask>& tasks = room.detectTasks;
+
+	groups.clear();
+	for (unsigned int p = 0; p < pairs.size(); p++)
+	{
+		if (p == 0 || pairs[p].query != pairs[p - 1].query)
+			groups.push_back(p);
+	}
+	unsigned int groupCount = static_cast<unsigned int>(groups.size());
+	groups.push_back(static_cast<unsigned int>(pairs.size()));
+
+	// a few runs per thread so one crowded corner does not hold up the rest
+	unsigned int taskCount = std::min(groupCount, (JobSystemGetWorkerCount() + 1) * 4);
+	if (tasks.size() < taskCount)
+		tasks.resize(taskCount);
+
+	JobParallelFor(taskCount, 1, [&room, dt, groupCount, taskCount](unsigned int begin, unsigned int end) {
+		for (unsigned int t = begin; t < end; t++)
+		{
+			DetectTask& task = room.detectTasks[t];
+			task.events.clear();
+
+			unsigned int g0 = groupCount * t / taskCount;
+			unsigned int g1 = groupCount * (t + 1) / taskCount;
+			for (unsigned int g = g0; g < g1; g++)
+				DetectAsteroid(room, room.groupScratch[g], room.groupScratch[g + 1], dt, task.batch, task.events);
+		}
+	});
+
+	room.eventScratch.clear();
+	for (unsigned int t = 0; t < taskCount; t++)
+		room.eventScratch.insert(room.eventScratch.end(), tasks[t].events.begin(), tasks[t].events.end());
+}
@@ -0,0 +1,216 @@
+/******************************************************************************/
+/*!
+\file			Platform.cpp
+\author
+\par
+\date
+\brief		This is the platform layer source file. When windowed it forwards
+					to the Alpha Engine, when SERVER_HEADLESS is defined it keeps its
+					own world bounds and paces frames with a high resolution clock.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "Platform.h"
+
+#ifdef SERVER_HEADLESS
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <csignal>
+#endif
+
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifndef SERVER_HEADLESS
+
+/******************************************************************************/
+/*!
+	Windowed build, everything goes through the Alpha Engine
+*/
+/******************************************************************************/
+void PlatformInit(unsigned int winWidth, unsigned int winHeight, unsigned int frameRate)
+{
+	UNREFERENCED_PARAMETER(winWidth);
+	UNREFERENCED_PARAMETER(winHeight);
+	UNREFERENCED_PARAMETER(frameRate);
+}
+
+void PlatformFrameStart()
+{
+	AESysFrameStart();
+	AEInputUpdate();
+}
+
+void PlatformFrameEnd()
+{
+	AESysFrameEnd();
+}
+
+bool PlatformQuitRequested()
+{
+	return (AESysDoesWindowExist() == false) || AEInputCheckTriggered(AEVK_ESCAPE);
+}
+
+f32 PlatformGetWinMinX() { return AEGfxGetWinMinX(); }
+f32 PlatformGetWinMaxX() { return AEGfxGetWinMaxX(); }
+f32 PlatformGetWinMinY() { return AEGfxGetWinMinY(); }
+f32 PlatformGetWinMaxY() { return AEGfxGetWinMaxY(); }
+
+f64 PlatformGetFrameTime()
+{
+	return AEFrameRateControllerGetFrameTime();
+}
+
+f32 PlatformWrap(f32 x, f32 x0, f32 x1)
+{
+	return AEWrap(x, x0, x1);
+}
+
+#else
+
+/******************************************************************************/
+/*!
+	Headless build
+*/
+/******************************************************************************/
+typedef std::chrono::steady_clock PlatformClock;
+
+static f32									sWinMinX, sWinMaxX, sWinMinY, sWinMaxY;
+static PlatformClock::duration	sFramePeriod;
+static PlatformClock::time_point sFrameStart;
+static f64									sFrameTime;
+static std::atomic<bool>		sQuitRequested{ false };
+
+static void PlatformSignalHandler(int)
+{
+	sQuitRequested = true;
+}
+
+void PlatformInit(unsigned int winWidth, unsigned int winHeight, unsigned int frameRate)
+{
+	// same convention as the engine, the origin is at the center of the window
+	sWinMaxX = static_cast<f32>(winWidth) / 2.0f;
+	sWinMinX = -sWinMaxX;
+	sWinMaxY = static_cast<f32>(winHeight) / 2.0f;
+	sWinMinY = -sWinMaxY;
+
+	sFramePeriod = std::chrono::duration_cast<PlatformClock::duration>(
+		std::chrono::duration<f64>(1.0 / static_cast<f64>(frameRate ? frameRate : 60)));
+	sFrameStart = PlatformClock::now();
+	sFrameTime = 0.0;
+
+	std::signal(SIGINT, PlatformSignalHandler);
+	std::signal(SIGTERM, PlatformSignalHandler);
+}
+
+void PlatformFrameStart()
+{
+}
+
+void PlatformFrameEnd()
+{
+	// sleep until the next frame boundary, then measure the real frame length
+	std::this_thread::sleep_until(sFrameStart + sFramePeriod);
+
+	PlatformClock::time_point now = PlatformClock::now();
+	sFrameTime = std::chrono::duration<f64>(now - sFrameStart).count();
+	sFrameStart = now;
+}
+
+bool PlatformQuitRequested()
+{
+	return sQuitRequested;
+}
+
+f32 PlatformGetWinMinX() { return sWinMinX; }
+f32 PlatformGetWinMaxX() { return sWinMaxX; }
+f32 PlatformGetWinMinY() { return sWinMinY; }
+f32 PlatformGetWinMaxY() { return sWinMaxY; }
+
+f64 PlatformGetFrameTime()
+{
+	return sFrameTime;
+}
+
+f32 PlatformWrap(f32 x, f32 x0, f32 x1)
+{
+	f32 range = x1 - x0;
+
+	if (x < x0)
+		return x + range;
+	if (x > x1)
+		return x - range;
+
+	return x;
+}
+
+#endif // SERVER_HEADLESS
+
+/******************************************************************************/
+/*!
+	Sockets
+*/
+/******************************************************************************/
+int PlatformNetInit()
+{
+#ifdef _WIN32
+	WSADATA wsaData{};
+	return WSAStartup(MAKEWORD(2, 2), &wsaData);
+#else
+	return NO_ERROR;
+#endif
+}
+
+void PlatformNetExit()
+{
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+bool PlatformNetWait(SOCKET socket, f64 seconds)
+{
+	if (seconds < 0.0)
+		seconds = 0.0;
+
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET(socket, &readable);
+
+	timeval timeout{};
+	timeout.tv_sec = static_cast<long>(seconds);
+	timeout.tv_usec = static_cast<long>((seconds - static_cast<f64>(timeout.tv_sec)) * 1000000.0);
+
+	// the first argument is ignored by winsock
+	return select(static_cast<int>(socket) + 1, &readable, nullptr, nullptr, &timeout) > 0;
+}
+
+/******************************************************************************/
+/*!
+	Threads
+*/
+/******************************************************************************/
+void PlatformPinThread(unsigned int core)
+{
+	unsigned int cores = std::thread::hardware_concurrency();
+	if (cores == 0)
+		return;
+	core %= cores;
+
+#ifdef _WIN32
+	SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core);
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
@@ -0,0 +1,788 @@
+/******************************************************************************/
+/*!
+\file			Protocol.cpp
+\author
+\par
+\date
+\brief		This is the wire protocol source file, the same on the client and
+					the server.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "Protocol.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+static const f32 PROTOCOL_PI = 3.14159265358979323846f;
+
+/******************************************************************************/
+/*!
+	Writer
+*/
+/******************************************************************************/
+void PacketWriterInit(PacketWriter& writer, void* data, unsigned int capacity)
+{
+	writer.data = static_cast<u8*>(data);
+	writer.capacity = capacity;
+	writer.size = 0;
+	writer.overflow = false;
+}
+
+void PacketWriteU8(PacketWriter& writer, u8 value)
+{
+	if (writer.size + 1 > writer.capacity)
+	{
+		writer.overflow = true;
+		return;
+	}
+	writer.data[writer.size++] = value;
+}
+
+void PacketWriteU16(PacketWriter& writer, u16 value)
+{
+	PacketWriteU8(writer, static_cast<u8>(value));
+	PacketWriteU8(writer, static_cast<u8>(value >> 8));
+}
+
+void PacketWriteU32(PacketWriter& writer, u32 value)
+{
+	PacketWriteU16(writer, static_cast<u16>(value));
+	PacketWriteU16(writer, static_cast<u16>(value >> 16));
+}
+
+void PacketWriteS16(PacketWriter& writer, s16 value)
+{
+	PacketWriteU16(writer, static_cast<u16>(value));
+}
+
+void PacketWriteS32(PacketWriter& writer, s32 value)
+{
+	PacketWriteU32(writer, static_cast<u32>(value));
+}
+
+void PacketWriteF32(PacketWriter& writer, f32 value)
+{
+	// the bits of an ieee float, both sides use them
+	u32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	PacketWriteU32(writer, bits);
+}
+
+void PacketWriteHeader(PacketWriter& writer, PACKET_TYPE type, u32 tick, u32 sequence)
+{
+	PacketWriteU16(writer, PROTOCOL_MAGIC);
+	PacketWriteU8(writer, PROTOCOL_VERSION);
+	PacketWriteU8(writer, static_cast<u8>(type));
+	PacketWriteU32(writer, tick);
+	PacketWriteU32(writer, sequence);
+}
+
+/******************************************************************************/
+/*!
+	Reader
+*/
+/******************************************************************************/
+void PacketReaderInit(PacketReader& reader, const void* data, unsigned int size)
+{
+	reader.data = static_cast<const u8*>(data);
+	reader.size = size;
+	reader.offset = 0;
+	reader.overflow = false;
+}
+
+u8 PacketReadU8(PacketReader& reader)
+{
+	if (reader.offset + 1 > reader.size)
+	{
+		reader.overflow = true;
+		return 0;
+	}
+	return reader.data[reader.offset++];
+}
+
+u16 PacketReadU16(PacketReader& reader)
+{
+	u16 low = PacketReadU8(reader);
+	u16 high = PacketReadU8(reader);
+	return static_cast<u16>(low | (high << 8));
+}
+
+u32 PacketReadU32(PacketReader& reader)
+{
+	u32 low = PacketReadU16(reader);
+	u32 high = PacketReadU16(reader);
+	return low | (high << 16);
+}
+
+s16 PacketReadS16(PacketReader& reader)
+{
+	return static_cast<s16>(PacketReadU16(reader));
+}
+
+s32 PacketReadS32(PacketReader& reader)
+{
+	return static_cast<s32>(PacketReadU32(reader));
+}
+
+f32 PacketReadF32(PacketReader& reader)
+{
+	u32 bits = PacketReadU32(reader);
+	f32 value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+bool PacketReadHeader(PacketReader& reader, PacketHeader& header)
+{
+	header.magic = PacketReadU16(reader);
+	header.version = PacketReadU8(reader);
+	header.type = PacketReadU8(reader);
+	header.tick = PacketReadU32(reader);
+	header.sequence = PacketReadU32(reader);
+
+	return !reader.overflow && header.magic == PROTOCOL_MAGIC && header.version == PROTOCOL_VERSION
+		&& header.type < PACKET_TYPE_NUM;
+}
+
+/******************************************************************************/
+/*!
+	Bits
+*/
+/******************************************************************************/
+void BitWriterInit(BitWriter& writer, PacketWriter& out)
+{
+	writer.out = &out;
+	writer.scratch = 0;
+	writer.count = 0;
+}
+
+void BitWrite(BitWriter& writer, u32 value, unsigned int bits)
+{
+	if (bits < 32)
+		value &= (1u << bits) - 1;
+
+	writer.scratch |= static_cast<u64>(value) << writer.count;
+	writer.count += bits;
+
+	while (writer.count >= 8)
+	{
+		PacketWriteU8(*writer.out, static_cast<u8>(writer.scratch));
+		writer.scratch >>= 8;
+		writer.count -= 8;
+	}
+}
+
+void BitWriterFlush(BitWriter& writer)
+{
+	if (writer.count > 0)
+		PacketWriteU8(*writer.out, static_cast<u8>(writer.scratch));
+
+	writer.scratch = 0;
+	writer.count = 0;
+}
+
+void BitReaderInit(BitReader& reader, PacketReader& in)
+{
+	reader.in = &in;
+	reader.scratch = 0;
+	reader.count = 0;
+}
+
+u32 BitRead(BitReader& reader, unsigned int bits)
+{
+	while (reader.count < bits)
+	{
+		reader.scratch |= static_cast<u64>(PacketReadU8(*reader.in)) << reader.count;
+		reader.count += 8;
+	}
+
+	u32 value = static_cast<u32>(reader.scratch & ((static_cast<u64>(1) << bits) - 1));
+	reader.scratch >>= bits;
+	reader.count -= bits;
+	return value;
+}
+
+void BitReaderAlign(BitReader& reader)
+{
+	reader.scratch = 0;
+	reader.count = 0;
+}
+
+/******************************************************************************/
+/*!
+	Quantization
+*/
+/******************************************************************************/
+u32 Quantize(f32 value, f32 min, f32 max, unsigned int bits)
+{
+	u32 steps = (bits < 32 ? (1u << bits) : 0u) - 1;
+
+	if (value <= min)
+		return 0;
+	if (value >= max)
+		return steps;
+
+	return static_cast<u32>(std::floor((value - min) / (max - min) * static_cast<f32>(steps) + 0.5f));
+}
+
+f32 Dequantize(u32 value, f32 min, f32 max, unsigned int bits)
+{
+	u32 steps = (bits < 32 ? (1u << bits) : 0u) - 1;
+	return min + (max - min) * (static_cast<f32>(value) / static_cast<f32>(steps));
+}
+
+f32 QuantizeError(f32 min, f32 max, unsigned int bits)
+{
+	u32 steps = (bits < 32 ? (1u << bits) : 0u) - 1;
+	return (max - min) / static_cast<f32>(steps) * 0.5f;
+}
+
+void QuantizeWrite(PacketWriter& writer, const QuantizeConfig& config)
+{
+	PacketWriteF32(writer, config.minX);
+	PacketWriteF32(writer, config.maxX);
+	PacketWriteF32(writer, config.minY);
+	PacketWriteF32(writer, config.maxY);
+	PacketWriteF32(writer, config.velocityMax);
+	PacketWriteU8(writer, config.positionBits);
+	PacketWriteU8(writer, config.angleBits);
+	PacketWriteU8(writer, config.velocityBits);
+	for (unsigned int i = 0; i < PROTOCOL_TYPE_NUM; i++)
+		PacketWriteF32(writer, config.defaultScale[i]);
+	PacketWriteU32(writer, config.driftX);
+	PacketWriteU32(writer, config.driftY);
+}
+
+void QuantizeRead(PacketReader& reader, QuantizeConfig& config)
+{
+	config.minX = PacketReadF32(reader);
+	config.maxX = PacketReadF32(reader);
+	config.minY = PacketReadF32(reader);
+	config.maxY = PacketReadF32(reader);
+	config.velocityMax = PacketReadF32(reader);
+	config.positionBits = PacketReadU8(reader);
+	config.angleBits = PacketReadU8(reader);
+	config.velocityBits = PacketReadU8(reader);
+	for (unsigned int i = 0; i < PROTOCOL_TYPE_NUM; i++)
+		config.defaultScale[i] = PacketReadF32(reader);
+	config.driftX = PacketReadU32(reader);
+	config.driftY = PacketReadU32(reader);
+}
+
+/******************************************************************************/
+/*!
+	Snapshot entities
+*/
+/******************************************************************************/
+void EntityStateQuantize(const QuantizeConfig& config, const SnapshotEntity& entity, EntityState& state)
+{
+	state.slot = entity.slot;
+	state.id = entity.slot;
+	state.type = static_cast<u8>(entity.type & (PROTOCOL_TYPE_NUM - 1));
+	state.moving = entity.velX != 0.0f || entity.velY != 0.0f;
+	state.x = Quantize(entity.posX, config.minX, config.maxX, config.positionBits);
+	state.y = Quantize(entity.posY, config.minY, config.maxY, config.positionBits);
+	state.angle = Quantize(entity.dir, -PROTOCOL_PI, PROTOCOL_PI, config.angleBits);
+	state.velX = state.moving ? Quantize(entity.velX, -config.velocityMax, config.velocityMax, config.velocityBits) : 0;
+	state.velY = state.moving ? Quantize(entity.velY, -config.velocityMax, config.velocityMax, config.velocityBits) : 0;
+	state.scale = entity.scale;
+	state.carryX = state.carryY = 0;
+}
+
+void EntityStateDequantize(const QuantizeConfig& config, const EntityState& state, SnapshotEntity& entity)
+{
+	entity.slot = state.slot;
+	entity.type = state.type;
+	entity.scale = state.scale;
+	entity.posX = Dequantize(state.x, config.minX, config.maxX, config.positionBits);
+	entity.posY = Dequantize(state.y, config.minY, config.maxY, config.positionBits);
+	entity.dir = Dequantize(state.angle, -PROTOCOL_PI, PROTOCOL_PI, config.angleBits);
+	entity.velX = state.moving ? Dequantize(state.velX, -config.velocityMax, config.velocityMax, config.velocityBits) : 0.0f;
+	entity.velY = state.moving ? Dequantize(state.velY, -config.velocityMax, config.velocityMax, config.velocityBits) : 0.0f;
+}
+
+// position moved by velocity steps over ticks, integers only so the client
+// gets the same answer whatever it was compiled with. the part of a step
+// it moved past the nearest one is carried to the next prediction
+static void PredictAxis(u32& position, s32& carry, u32 velocity, u32 drift, u32 ticks, const QuantizeConfig& config)
+{
+	s64 velocitySteps = (static_cast<s64>(1) << config.velocityBits) - 1;
+	s64 moved = (2 * static_cast<s64>(velocity) - velocitySteps) * static_cast<s64>(ticks) * static_cast<s64>(drift);
+	s64 to = (static_cast<s64>(position) << 16) + carry + moved;
+	s64 last = (static_cast<s64>(1) << config.positionBits) - 1;
+
+	if (to < 0 || to > (last << 16))
+	{
+		position = static_cast<u32>(to < 0 ? 0 : last);
+		carry = 0;
+		return;
+	}
+
+	position = static_cast<u32>((to + 0x8000) >> 16);
+	carry = static_cast<s32>(to - (static_cast<s64>(position) << 16));
+}
+
+void EntityStatePredict(const QuantizeConfig& config, EntityState& state, u32 ticks)
+{
+	if (!state.moving || ticks == 0)
+		return;
+
+	PredictAxis(state.x, state.carryX, state.velX, config.driftX, ticks, config);
+	PredictAxis(state.y, state.carryY, state.velY, config.driftY, ticks, config);
+}
+
+static void WriteScale(BitWriter& writer, f32 scale)
+{
+	u32 bits;
+	memcpy(&bits, &scale, sizeof(bits));
+	BitWrite(writer, bits, 32);
+}
+
+static f32 ReadScale(BitReader& reader)
+{
+	u32 bits = BitRead(reader, 32);
+	f32 scale;
+	memcpy(&scale, &bits, sizeof(scale));
+	return scale;
+}
+
+// everything but the slot
+static void WriteState(BitWriter& writer, const QuantizeConfig& config, const EntityState& state)
+{
+	bool scale = state.scale != config.defaultScale[state.type];
+
+	BitWrite(writer, state.type, PROTOCOL_TYPE_BITS);
+	BitWrite(writer, scale ? 1 : 0, 1);
+	BitWrite(writer, state.moving ? 1 : 0, 1);
+	BitWrite(writer, state.x, config.positionBits);
+	BitWrite(writer, state.y, config.positionBits);
+	BitWrite(writer, state.angle, config.angleBits);
+	if (scale)
+		WriteScale(writer, state.scale);
+	if (state.moving)
+	{
+		BitWrite(writer, state.velX, config.velocityBits);
+		BitWrite(writer, state.velY, config.velocityBits);
+	}
+}
+
+static void ReadState(BitReader& reader, const QuantizeConfig& config, EntityState& state)
+{
+	state.type = static_cast<u8>(BitRead(reader, PROTOCOL_TYPE_BITS));
+	bool scale = BitRead(reader, 1) != 0;
+	state.moving = BitRead(reader, 1) != 0;
+	state.x = BitRead(reader, config.positionBits);
+	state.y = BitRead(reader, config.positionBits);
+	state.angle = BitRead(reader, config.angleBits);
+	state.scale = scale ? ReadScale(reader) : config.defaultScale[state.type];
+	state.velX = state.moving ? BitRead(reader, config.velocityBits) : 0;
+	state.velY = state.moving ? BitRead(reader, config.velocityBits) : 0;
+	state.carryX = state.carryY = 0;
+}
+
+void SnapshotWriteEntity(BitWriter& writer, const QuantizeConfig& config, const EntityState& state)
+{
+	BitWrite(writer, state.slot, PROTOCOL_SLOT_BITS);
+	WriteState(writer, config, state);
+}
+
+void SnapshotReadEntity(BitReader& reader, const QuantizeConfig& config, EntityState& state)
+{
+	state.slot = BitRead(reader, PROTOCOL_SLOT_BITS);
+	state.id = state.slot;
+	ReadState(reader, config, state);
+}
+
+unsigned int SnapshotEntityBits(const QuantizeConfig& config, bool scale, bool velocity)
+{
+	return PROTOCOL_SLOT_BITS + PROTOCOL_TYPE_BITS + 2 + 2 * config.positionBits + config.angleBits
+		+ (scale ? 32 : 0) + (velocity ? 2 * config.velocityBits : 0);
+}
+
+/******************************************************************************/
+/*!
+	Snapshot history
+*/
+/******************************************************************************/
+void SnapshotHistoryInit(SnapshotHistory& history)
+{
+	for (unsigned int i = 0; i < PROTOCOL_SNAPSHOT_HISTORY; i++)
+	{
+		history.frames[i].sequence = SNAPSHOT_NONE;
+		history.frames[i].objects.clear();
+	}
+	history.acked = SNAPSHOT_NONE;
+}
+
+SnapshotFrame* SnapshotHistoryBaseline(SnapshotHistory& history, u32 sequence, u32 next)
+{
+	if (sequence == SNAPSHOT_NONE || next - sequence - 1 >= PROTOCOL_SNAPSHOT_HISTORY - 1)
+		return nullptr;
+
+	SnapshotFrame& frame = history.frames[sequence & (PROTOCOL_SNAPSHOT_HISTORY - 1)];
+	return frame.sequence == sequence ? &frame : nullptr;
+}
+
+SnapshotFrame& SnapshotHistoryAdd(SnapshotHistory& history, u32 sequence, u32 tick)
+{
+	SnapshotFrame& frame = history.frames[sequence & (PROTOCOL_SNAPSHOT_HISTORY - 1)];
+	frame.sequence = sequence;
+	frame.tick = tick;
+	frame.objects.clear();
+	frame.fragments = 0;
+	frame.received = 0;
+	return frame;
+}
+
+/******************************************************************************/
+/*!
+	Snapshot deltas
+*/
+/******************************************************************************/
+static u32 Distance(u32 a, u32 b)
+{
+	return a > b ? a - b : b - a;
+}
+
+void SnapshotDiff(const QuantizeConfig& config, const SnapshotFrame* baseline, const std::vector<EntityState>& current,
+	u32 tolerance, SnapshotFrame& sent, std::vector<u32>& removed, std::vector<SnapshotChange>& changes)
+{
+	static const std::vector<EntityState> none;
+	const std::vector<EntityState>& base = baseline ? baseline->objects : none;
+	u32 ticks = baseline ? sent.tick - baseline->tick : 0;
+
+	// both lists are sorted by slot, so one walk finds what left, what came
+	// and what moved other than predicted
+	removed.clear();
+	changes.clear();
+	size_t b = 0, c = 0;
+	while (b < base.size() || c < current.size())
+	{
+		if (c == current.size() || (b < base.size() && base[b].slot < current[c].slot))
+		{
+			removed.push_back(base[b++].slot);
+			continue;
+		}
+
+		const EntityState& now = current[c++];
+		if (b == base.size() || now.slot < base[b].slot)
+		{
+			changes.push_back(SnapshotChange{ static_cast<unsigned int>(sent.objects.size()), SNAPSHOT_CHANGE_SPAWN });
+			sent.objects.push_back(now);
+			continue;
+		}
+
+		EntityState was = base[b++];
+		if (was.id != now.id || was.type != now.type)
+		{
+			changes.push_back(SnapshotChange{ static_cast<unsigned int>(sent.objects.size()), SNAPSHOT_CHANGE_SPAWN });
+			sent.objects.push_back(now);
+			continue;
+		}
+
+		EntityStatePredict(config, was, ticks);
+
+		unsigned int mask = 0;
+		if (Distance(was.x, now.x) > tolerance || Distance(was.y, now.y) > tolerance)
+		{
+			mask |= SNAPSHOT_CHANGE_POSITION;
+			was.x = now.x;
+			was.y = now.y;
+			was.carryX = was.carryY = 0;
+		}
+		if (was.angle != now.angle)
+		{
+			mask |= SNAPSHOT_CHANGE_ANGLE;
+			was.angle = now.angle;
+		}
+		if (was.moving != now.moving || was.velX != now.velX || was.velY != now.velY)
+		{
+			mask |= SNAPSHOT_CHANGE_VELOCITY;
+			was.moving = now.moving;
+			was.velX = now.velX;
+			was.velY = now.velY;
+		}
+		if (was.scale != now.scale)
+		{
+			mask |= SNAPSHOT_CHANGE_SCALE;
+			was.scale = now.scale;
+		}
+
+		if (mask)
+			changes.push_back(SnapshotChange{ static_cast<unsigned int>(sent.objects.size()), mask });
+		sent.objects.push_back(was);
+	}
+}
+
+// the object in slot or where it goes
+static std::vector<EntityState>::iterator FindSlot(std::vector<EntityState>& objects, u32 slot)
+{
+	return std::lower_bound(objects.begin(), objects.end(), slot,
+		[](const EntityState& state, u32 value) { return state.slot < value; });
+}
+
+void SnapshotDefer(const QuantizeConfig& config, const SnapshotFrame* baseline, SnapshotFrame& sent,
+	std::vector<u32>& removed, unsigned int keepRemoved, std::vector<SnapshotChange>& changes, unsigned int keepChanges)
+{
+	if (keepRemoved >= removed.size() && keepChanges >= changes.size())
+		return;
+
+	static const std::vector<EntityState> none;
+	const std::vector<EntityState>& base = baseline ? baseline->objects : none;
+	u32 ticks = baseline ? sent.tick - baseline->tick : 0;
+
+	bool erased = false;
+	for (unsigned int i = keepChanges; i < changes.size(); i++)
+	{
+		EntityState& state = sent.objects[changes[i].object];
+		auto was = std::lower_bound(base.begin(), base.end(), state.slot,
+			[](const EntityState& object, u32 value) { return object.slot < value; });
+		if (was == base.end() || was->slot != state.slot)
+		{
+			state.slot = SNAPSHOT_NONE;
+			erased = true;
+			continue;
+		}
+
+		state = *was;
+		EntityStatePredict(config, state, ticks);
+	}
+
+	// the kept changes point at their objects again once the unsent spawns
+	// are gone and the objects still to remove are back
+	for (unsigned int i = 0; i < keepChanges; i++)
+		changes[i].object = sent.objects[changes[i].object].slot;
+	changes.resize(keepChanges);
+	if (erased)
+	{
+		sent.objects.erase(std::remove_if(sent.objects.begin(), sent.objects.end(),
+			[](const EntityState& state) { return state.slot == SNAPSHOT_NONE; }), sent.objects.end());
+	}
+	if (keepRemoved < removed.size())
+	{
+		for (unsigned int i = keepRemoved; i < removed.size(); i++)
+		{
+			auto was = std::lower_bound(base.begin(), base.end(), removed[i],
+				[](const EntityState& object, u32 value) { return object.slot < value; });
+			sent.objects.push_back(*was);
+			EntityStatePredict(config, sent.objects.back(), ticks);
+		}
+		removed.resize(keepRemoved);
+		std::sort(sent.objects.begin(), sent.objects.end(),
+			[](const EntityState& a, const EntityState& b) { return a.slot < b.slot; });
+	}
+	for (SnapshotChange& change : changes)
+		change.object = static_cast<unsigned int>(FindSlot(sent.objects, change.object) - sent.objects.begin());
+}
+
+unsigned int SnapshotChangeBits(const QuantizeConfig& config, const EntityState& state, unsigned int mask)
+{
+	if (mask & SNAPSHOT_CHANGE_SPAWN)
+		return 1 + SnapshotEntityBits(config, state.scale != config.defaultScale[state.type], state.moving);
+
+	unsigned int bits = PROTOCOL_SLOT_BITS + 1 + 4;
+	if (mask & SNAPSHOT_CHANGE_POSITION)
+		bits += 2 * config.positionBits;
+	if (mask & SNAPSHOT_CHANGE_ANGLE)
+		bits += config.angleBits;
+	if (mask & SNAPSHOT_CHANGE_VELOCITY)
+		bits += 1 + (state.moving ? 2 * config.velocityBits : 0);
+	if (mask & SNAPSHOT_CHANGE_SCALE)
+		bits += 32;
+	return bits;
+}
+
+// bits of removals and changes one fragment carries, and the bytes it takes
+static const unsigned int FRAGMENT_PAYLOAD_BITS = (PROTOCOL_FRAGMENT_SIZE - PROTOCOL_FRAGMENT_HEADER_SIZE) * 8 - 2 * PROTOCOL_COUNT_BITS;
+
+static unsigned int FragmentBytes(unsigned int used)
+{
+	return PROTOCOL_FRAGMENT_HEADER_SIZE + (used + 2 * PROTOCOL_COUNT_BITS + 7) / 8;
+}
+
+void SnapshotPackingInit(SnapshotPacking& packing, unsigned int firstBits)
+{
+	packing.bytes = 0;
+	packing.used = firstBits;
+}
+
+unsigned int SnapshotPackingAdd(SnapshotPacking& packing, unsigned int bits)
+{
+	if (packing.used + bits > FRAGMENT_PAYLOAD_BITS && packing.used > 0)
+	{
+		packing.bytes += FragmentBytes(packing.used);
+		packing.used = 0;
+	}
+	packing.used += bits;
+	return packing.bytes + FragmentBytes(packing.used);
+}
+
+void SnapshotPlanFragments(const QuantizeConfig& config, const SnapshotFrame& sent, const std::vector<u32>& removed,
+	const std::vector<SnapshotChange>& changes, unsigned int firstBits, std::vector<SnapshotFragment>& fragments)
+{
+	// with 11 bit slots a whole snapshot is a few dozen fragments at most
+	const unsigned int budget = FRAGMENT_PAYLOAD_BITS;
+	const unsigned int countMax = (1u << PROTOCOL_COUNT_BITS) - 1;
+
+	fragments.clear();
+	SnapshotFragment fragment{ 0, 0, 0, 0 };
+	unsigned int used = firstBits;
+	auto next = [&]() {
+		fragments.push_back(fragment);
+		fragment = SnapshotFragment{ fragment.removedEnd, fragment.removedEnd, fragment.changeEnd, fragment.changeEnd };
+		used = 0;
+	};
+
+	while (fragment.removedEnd < removed.size())
+	{
+		if ((used + PROTOCOL_SLOT_BITS > budget && used > 0) || fragment.removedEnd - fragment.removedBegin == countMax)
+			next();
+		used += PROTOCOL_SLOT_BITS;
+		fragment.removedEnd++;
+	}
+
+	while (fragment.changeEnd < changes.size())
+	{
+		const SnapshotChange& change = changes[fragment.changeEnd];
+		unsigned int bits = SnapshotChangeBits(config, sent.objects[change.object], change.mask);
+		if ((used + bits > budget && used > 0) || fragment.changeEnd - fragment.changeBegin == countMax)
+			next();
+		used += bits;
+		fragment.changeEnd++;
+	}
+
+	fragments.push_back(fragment);
+}
+
+void SnapshotWriteFragment(BitWriter& writer, const QuantizeConfig& config, const SnapshotFrame& sent,
+	const std::vector<u32>& removed, const std::vector<SnapshotChange>& changes, const SnapshotFragment& fragment)
+{
+	BitWrite(writer, fragment.removedEnd - fragment.removedBegin, PROTOCOL_COUNT_BITS);
+	BitWrite(writer, fragment.changeEnd - fragment.changeBegin, PROTOCOL_COUNT_BITS);
+	for (unsigned int i = fragment.removedBegin; i < fragment.removedEnd; i++)
+		BitWrite(writer, removed[i], PROTOCOL_SLOT_BITS);
+
+	for (unsigned int i = fragment.changeBegin; i < fragment.changeEnd; i++)
+	{
+		const SnapshotChange& change = changes[i];
+		const EntityState& state = sent.objects[change.object];
+		BitWrite(writer, state.slot, PROTOCOL_SLOT_BITS);
+		BitWrite(writer, change.mask & SNAPSHOT_CHANGE_SPAWN ? 1 : 0, 1);
+		if (change.mask & SNAPSHOT_CHANGE_SPAWN)
+		{
+			WriteState(writer, config, state);
+			continue;
+		}
+
+		BitWrite(writer, change.mask & SNAPSHOT_CHANGE_POSITION ? 1 : 0, 1);
+		if (change.mask & SNAPSHOT_CHANGE_POSITION)
+		{
+			BitWrite(writer, state.x, config.positionBits);
+			BitWrite(writer, state.y, config.positionBits);
+		}
+		BitWrite(writer, change.mask & SNAPSHOT_CHANGE_ANGLE ? 1 : 0, 1);
+		if (change.mask & SNAPSHOT_CHANGE_ANGLE)
+			BitWrite(writer, state.angle, config.angleBits);
+		BitWrite(writer, change.mask & SNAPSHOT_CHANGE_VELOCITY ? 1 : 0, 1);
+		if (change.mask & SNAPSHOT_CHANGE_VELOCITY)
+		{
+			BitWrite(writer, state.moving ? 1 : 0, 1);
+			if (state.moving)
+			{
+				BitWrite(writer, state.velX, config.velocityBits);
+				BitWrite(writer, state.velY, config.velocityBits);
+			}
+		}
+		BitWrite(writer, change.mask & SNAPSHOT_CHANGE_SCALE ? 1 : 0, 1);
+		if (change.mask & SNAPSHOT_CHANGE_SCALE)
+			WriteScale(writer, state.scale);
+	}
+}
+
+bool SnapshotFrameComplete(const SnapshotFrame& frame)
+{
+	u64 all = frame.fragments >= 64 ? ~static_cast<u64>(0) : (static_cast<u64>(1) << frame.fragments) - 1;
+	return frame.fragments != 0 && frame.received == all;
+}
+
+void SnapshotFrameStart(const QuantizeConfig& config, const SnapshotFrame* baseline, SnapshotFrame& frame)
+{
+	frame.objects.clear();
+	frame.fragments = 0;
+	frame.received = 0;
+	if (!baseline)
+		return;
+
+	frame.objects = baseline->objects;
+	for (EntityState& state : frame.objects)
+		EntityStatePredict(config, state, frame.tick - baseline->tick);
+}
+
+bool SnapshotReadFragment(BitReader& reader, const QuantizeConfig& config, SnapshotFrame& frame)
+{
+	// every slot is in one fragment only, so they apply in any order
+	u32 removedCount = BitRead(reader, PROTOCOL_COUNT_BITS);
+	u32 changedCount = BitRead(reader, PROTOCOL_COUNT_BITS);
+	for (u32 i = 0; i < removedCount; i++)
+	{
+		u32 slot = BitRead(reader, PROTOCOL_SLOT_BITS);
+		auto found = FindSlot(frame.objects, slot);
+		if (found == frame.objects.end() || found->slot != slot)
+			return false;
+		frame.objects.erase(found);
+	}
+
+	for (u32 i = 0; i < changedCount; i++)
+	{
+		u32 slot = BitRead(reader, PROTOCOL_SLOT_BITS);
+		auto found = FindSlot(frame.objects, slot);
+		bool known = found != frame.objects.end() && found->slot == slot;
+
+		if (BitRead(reader, 1))
+		{
+			EntityState state{};
+			state.slot = slot;
+			state.id = slot;
+			ReadState(reader, config, state);
+			if (known)
+				*found = state;
+			else
+				frame.objects.insert(found, state);
+			continue;
+		}
+
+		// only an object of the baseline can change
+		if (!known)
+			return false;
+
+		EntityState& state = *found;
+		if (BitRead(reader, 1))
+		{
+			state.x = BitRead(reader, config.positionBits);
+			state.y = BitRead(reader, config.positionBits);
+			state.carryX = state.carryY = 0;
+		}
+		if (BitRead(reader, 1))
+			state.angle = BitRead(reader, config.angleBits);
+		if (BitRead(reader, 1))
+		{
+			state.moving = BitRead(reader, 1) != 0;
+			state.velX = state.moving ? BitRead(reader, config.velocityBits) : 0;
+			state.velY = state.moving ? BitRead(reader, config.velocityBits) : 0;
+		}
+		if (BitRead(reader, 1))
+			state.scale = ReadScale(reader);
+	}
+
+	return !reader.in->overflow;
+}
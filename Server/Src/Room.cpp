@@ -0,0 +1,206 @@
+/******************************************************************************/
+/*!
+\file			Room.cpp
+\author
+\par
+\date
+\brief		This is the room source file. Every shard keeps its rooms by
+					index, the rest of a room id, refills the indices closed rooms
+					left lowest first and finds its players by address through a
+					hash map instead of walking every room.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "Room.h"
+#include "SimClock.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+
+// the rooms of one shard and the players that joined them
+struct RoomSet
+{
+	std::vector<std::unique_ptr<Room>>			rooms;			// nullptr where a room was closed
+	std::vector<u32>												generations;	// times every index was closed
+	std::vector<unsigned int>								freed;			// indices closed rooms left, a min heap
+	std::unordered_map<u64, unsigned int>		clients;		// keyed by RoomAddressKey, room index * MAX_CLIENTS + entry
+	unsigned int														openFrom;		// rooms below this are full or closed
+};
+
+/******************************************************************************/
+/*!
+	Static Variables
+*/
+/******************************************************************************/
+static std::vector<RoomSet>		sSets;			// one per shard, sized before any shard thread starts
+
+/******************************************************************************/
+/*!
+	IPv4 address and port of a player as one number
+*/
+/******************************************************************************/
+static inline u64 RoomAddressKey(const sockaddr_in& address)
+{
+	return (static_cast<u64>(address.sin_addr.s_addr) << 16) | address.sin_port;
+}
+
+/******************************************************************************/
+/*!
+	One room set per shard
+*/
+/******************************************************************************/
+void RoomsInit(unsigned int shardCount)
+{
+	sSets.clear();
+	sSets.resize(shardCount);
+}
+
+void RoomDestroyAll()
+{
+	for (RoomSet& set : sSets)
+	{
+		for (std::unique_ptr<Room>& room : set.rooms)
+		{
+			if (room)
+				BroadphaseDestroy(room->broadphase);
+		}
+
+		set.rooms.clear();
+		set.generations.clear();
+		set.freed.clear();
+		set.clients.clear();
+		set.openFrom = 0;
+	}
+}
+
+/******************************************************************************/
+/*!
+	Opening, closing and finding the rooms of one shard
+*/
+/******************************************************************************/
+Room* RoomCreate(unsigned int shard, SOCKET socket)
+{
+	RoomSet& set = sSets[shard];
+
+	unsigned int index;
+	if (!set.freed.empty()) {
+		std::pop_heap(set.freed.begin(), set.freed.end(), std::greater<unsigned int>());
+		index = set.freed.back();
+		set.freed.pop_back();
+	}
+	else if (set.rooms.size() < ROOM_NUM_MAX) {
+		index = static_cast<unsigned int>(set.rooms.size());
+		set.rooms.emplace_back();
+		set.generations.push_back(0);
+	}
+	else {
+		return nullptr;
+	}
+
+	std::unique_ptr<Room> room{ new Room{} };
+	u32 generation = set.generations[index] & ((1u << ROOM_GENERATION_BITS) - 1);
+	room->id = (generation << (ROOM_SHARD_BITS + ROOM_INDEX_BITS)) | (index << ROOM_SHARD_BITS) | shard;
+	room->socket = socket;
+	room->broadphase = BroadphaseCreate();
+	EntityStoreInit(room->store, GAME_OBJ_INST_NUM_MAX);
+
+	// a reused index below the search start has seats again
+	set.openFrom = std::min(set.openFrom, index);
+	set.rooms[index] = std::move(room);
+	return set.rooms[index].get();
+}
+
+void RoomDestroy(Room& room)
+{
+	RoomSet& set = sSets[RoomShard(room.id)];
+	unsigned int index = RoomIndex(room.id);
+
+	for (const sockaddr_in& address : room.clients)
+		set.clients.erase(RoomAddressKey(address));
+
+	BroadphaseDestroy(room.broadphase);
+	set.rooms[index].reset();
+	set.generations[index]++;
+	set.freed.push_back(index);
+	std::push_heap(set.freed.begin(), set.freed.end(), std::greater<unsigned int>());
+}
+
+Room* RoomFind(RoomID id)
+{
+	unsigned int shard = RoomShard(id);
+	unsigned int index = RoomIndex(id);
+	if (shard >= sSets.size() || index >= sSets[shard].rooms.size())
+		return nullptr;
+
+	Room* room = sSets[shard].rooms[index].get();
+	return room && room->id == id ? room : nullptr;
+}
+
+Room* RoomFindClient(unsigned int shard, const sockaddr_in& address, unsigned int* client)
+{
+	RoomSet& set = sSets[shard];
+
+	auto it = set.clients.find(RoomAddressKey(address));
+	if (it == set.clients.end())
+		return nullptr;
+
+	if (client)
+		*client = it->second % MAX_CLIENTS;
+	return set.rooms[it->second / MAX_CLIENTS].get();
+}
+
+Room* RoomFindOpen(unsigned int shard)
+{
+	RoomSet& set = sSets[shard];
+
+	// an open room only ever fills up, the search carries on from the last one
+	// with seats and RoomCreate moves it back for a reused index
+	for (; set.openFrom < set.rooms.size(); set.openFrom++)
+	{
+		Room* room = set.rooms[set.openFrom].get();
+		if (room && room->clients.size() < g_roomPlayers)
+			return room;
+	}
+
+	return nullptr;
+}
+
+void RoomAddClient(Room& room, const sockaddr_in& address)
+{
+	RoomSet& set = sSets[RoomShard(room.id)];
+
+	unsigned int index = RoomIndex(room.id);
+	set.clients[RoomAddressKey(address)] = index * MAX_CLIENTS + static_cast<unsigned int>(room.clients.size());
+	room.clients.push_back(address);
+
+	room.inputs.emplace_back();
+	InputBufferInit(room.inputs.back(), g_inputDelay);
+
+	room.snapshots.emplace_back();
+	SnapshotHistoryInit(room.snapshots.back());
+
+	room.priorities.emplace_back(1u << PROTOCOL_SLOT_BITS, 0.0f);
+	room.interests.emplace_back();
+	room.heard.push_back(SimClockGetTick());
+}
+
+unsigned int RoomGetCount(unsigned int shard)
+{
+	return static_cast<unsigned int>(sSets[shard].rooms.size());
+}
+
+Room* RoomGet(unsigned int shard, unsigned int index)
+{
+	return sSets[shard].rooms[index].get();
+}
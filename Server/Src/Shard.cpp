@@ -0,0 +1,521 @@
+/******************************************************************************/
+/*!
+\file			Shard.cpp
+\author
+\par
+\date
+\brief		This is the shard source file. Every shard thread waits on its
+					socket until the next tick is due, applies what came in, runs
+					the ticks of its rooms and sends their snapshots. The only
+					things shared between shards are the input queues, for
+					datagrams that reached the wrong socket, and the load counters.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "Shard.h"
+#include "Main.h"
+#include "Room.h"
+#include "SimClock.h"
+#include "InputQueue.h"
+#include "Protocol.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+typedef std::chrono::steady_clock ShardClock;
+
+struct Shard
+{
+	unsigned int							index;
+	SOCKET										socket{ INVALID_SOCKET };
+	std::thread								thread;
+
+	// what came in for its rooms, on its own socket or another shard's
+	InputQueue								inputs;
+
+	// shard every address that asked to join from here was sent to, so a
+	// second join goes the same way, until that shard closes its room. only
+	// the shard's own thread uses it
+	std::unordered_map<u64, unsigned int>	joinedTo;
+
+	std::atomic<unsigned int>	rooms;
+	std::atomic<unsigned int>	players;
+	std::atomic<unsigned int>	openSeats;
+	std::atomic<u64>					ticks;
+	std::atomic<u64>					tickMicroseconds;
+	std::atomic<u64>					packetsIn;
+	std::atomic<u64>					packetsOut;
+	std::atomic<u64>					bytesOut;
+	std::atomic<u64>					forwarded;
+};
+
+/******************************************************************************/
+/*!
+	Static Variables
+*/
+/******************************************************************************/
+static std::unique_ptr<Shard[]>		sShards;
+static unsigned int								sCount;
+static std::atomic<bool>					sRunning{ false };
+
+/******************************************************************************/
+/*!
+	Makes the kernel give every datagram to the socket named by the low byte
+	of its room id. A join names no room, its byte is past the last socket
+	and the kernel then picks by address hash instead
+*/
+/******************************************************************************/
+static void ShardAttachSteering(SOCKET socket)
+{
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+	sock_filter code[] = {
+		{ BPF_LD | BPF_B | BPF_ABS, 0, 0, PROTOCOL_ROOM_OFFSET },	// A = low byte of the room id
+		{ BPF_RET | BPF_A, 0, 0, 0 },															// socket A of the group
+	};
+	sock_fprog program{};
+	program.len = sizeof(code) / sizeof(code[0]);
+	program.filter = code;
+
+	if (setsockopt(socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == 0)
+		return;
+#else
+	UNREFERENCED_PARAMETER(socket);
+#endif
+	std::cerr << "Shard steering not available, inputs are forwarded between shards" << std::endl;
+}
+
+/******************************************************************************/
+/*!
+	IPv4 address and port of a player as one number
+*/
+/******************************************************************************/
+static inline u64 ShardAddressKey(const sockaddr_in& address)
+{
+	return (static_cast<u64>(address.sin_addr.s_addr) << 16) | address.sin_port;
+}
+
+/******************************************************************************/
+/*!
+	Recounts the load of the shard after a join or a room closed
+*/
+/******************************************************************************/
+static void ShardUpdateLoad(Shard& shard)
+{
+	unsigned int rooms{}, players{}, openSeats{};
+	unsigned int count = RoomGetCount(shard.index);
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		Room* room = RoomGet(shard.index, i);
+		if (!room)
+			continue;
+
+		unsigned int clients = static_cast<unsigned int>(room->clients.size());
+		rooms++;
+		players += clients;
+		openSeats += clients < g_roomPlayers ? g_roomPlayers - clients : 0;
+	}
+
+	shard.rooms = rooms;
+	shard.players = players;
+	shard.openSeats = openSeats;
+}
+
+/******************************************************************************/
+/*!
+	Puts a player in a room of this shard and tells it where it went
+*/
+/******************************************************************************/
+static void ShardJoin(Shard& shard, const sockaddr_in& from)
+{
+	EntityHandle ship{};
+	Room* room{ JoinRoom(shard.index, shard.socket, from, ship) };
+	if (!room) {
+		std::cerr << "Every room is taken" << std::endl;
+		return;
+	}
+
+	// Send Ship ID to client
+	SERVER_INITIAL_MESSAGE_FORMAT toSend{};
+	// the client echoes this handle back, a recycled slot is then told apart
+	toSend.ShipID = static_cast<int>(ship);
+	toSend.RoomID = static_cast<int>(room->id);
+	toSend.TickRate = static_cast<int>(SimClockGetTickRate());
+	std::cout << "CREATED SHIP: " << toSend.ShipID << " IN ROOM: " << toSend.RoomID << "\n";
+
+	u8 buffer[PROTOCOL_HEADER_SIZE + 10 + sizeof(QuantizeConfig)];
+	PacketWriter writer;
+	PacketWriterInit(writer, buffer, sizeof(buffer));
+	PacketWriteHeader(writer, PACKET_JOIN_REPLY, SimClockGetTick(), 0);
+	PacketWriteU32(writer, static_cast<u32>(toSend.ShipID));
+	PacketWriteU32(writer, static_cast<u32>(toSend.RoomID));
+	PacketWriteU16(writer, static_cast<u16>(toSend.TickRate));
+	QuantizeWrite(writer, g_quantize);
+
+	sendto(shard.socket,
+		reinterpret_cast<const char*>(buffer),
+		static_cast<int>(writer.size),
+		0,
+		reinterpret_cast<const sockaddr*>(&from),
+		sizeof(from));
+
+	ShardUpdateLoad(shard);
+}
+
+/******************************************************************************/
+/*!
+	Works on a datagram meant for this shard
+*/
+/******************************************************************************/
+static void ShardApply(Shard& shard, const InputCommand& command)
+{
+	if (command.type == INPUT_COMMAND_JOIN) {
+		ShardJoin(shard, command.from);
+		return;
+	}
+	if (command.type == INPUT_COMMAND_LEAVE) {
+		shard.joinedTo.erase(ShardAddressKey(command.from));
+		return;
+	}
+
+	Room* room{ RoomFind(static_cast<RoomID>(command.message.RoomID)) };
+	if (room) {
+		RoomQueueInput(*room, command.from, command.message);
+	}
+}
+
+/******************************************************************************/
+/*!
+	Receives one datagram and queues it for the shard that owns it
+*/
+/******************************************************************************/
+static void ShardReceive(Shard& shard)
+{
+	InputCommand packet{};
+	socklen_t fromLen = sizeof(packet.from);
+	char buffer[1024];
+
+	int bytesRead = static_cast<int>(recvfrom(shard.socket, buffer, sizeof(buffer), 0,
+		reinterpret_cast<sockaddr*>(&packet.from), &fromLen));
+	if (bytesRead == SOCKET_ERROR) {
+		std::cerr << "recvfrom() failed: " << WSAGetLastError() << std::endl;
+		return;
+	}
+	shard.packetsIn.fetch_add(1);
+
+	// anything that is not ours, or of another version, is dropped
+	PacketReader reader;
+	PacketHeader header;
+	PacketReaderInit(reader, buffer, static_cast<unsigned int>(bytesRead));
+	if (!PacketReadHeader(reader, header)) {
+		return;
+	}
+
+	// a player already in a room that asks to join is told the same room and
+	// ship again
+	unsigned int owner;
+	if (header.type == PACKET_JOIN) {
+		std::cout << "Received join request" << std::endl;
+
+		packet.type = INPUT_COMMAND_JOIN;
+		u64 key = ShardAddressKey(packet.from);
+		auto it = shard.joinedTo.find(key);
+		if (it != shard.joinedTo.end()) {
+			owner = it->second;
+		}
+		else {
+			owner = ShardPick();
+			shard.joinedTo[key] = owner;
+		}
+	}
+	else if (header.type == PACKET_INPUT) {
+		packet.type = INPUT_COMMAND_INPUT;
+		packet.message.RoomID = static_cast<int>(PacketReadU32(reader));
+		packet.message.ShipID = static_cast<int>(PacketReadU32(reader));
+		packet.message.Ack = PacketReadU32(reader);
+		packet.message.Tick = static_cast<int>(header.tick);
+		for (int i = 0; i < INPUT_REDUNDANCY; ++i) {
+			packet.message.Keys[i] = PacketReadU8(reader);
+		}
+
+		owner = RoomShard(static_cast<RoomID>(packet.message.RoomID));
+		if (reader.overflow || owner >= sCount) {
+			return;
+		}
+	}
+	else {
+		return;
+	}
+
+	// nothing touches a room before its next tick, a full queue drops it like
+	// the network would
+	InputQueuePush(sShards[owner].inputs, packet);
+	if (owner != shard.index)
+		shard.forwarded.fetch_add(1);
+}
+
+/******************************************************************************/
+/*!
+	Closes the rooms none of whose players sent anything valid for
+	ROOM_IDLE_TIMEOUT. The shard that saw a player's join is not known here,
+	every shard is told to forget it, rooms close rarely enough
+*/
+/******************************************************************************/
+static void ShardCloseIdle(Shard& shard)
+{
+	u32 tick = SimClockGetTick();
+	u32 timeout = static_cast<u32>(ROOM_IDLE_TIMEOUT * SimClockGetTickRate());
+
+	bool closed{};
+	unsigned int rooms = RoomGetCount(shard.index);
+	for (unsigned int r = 0; r < rooms; ++r)
+	{
+		Room* room = RoomGet(shard.index, r);
+		if (!room)
+			continue;
+
+		bool idle = true;
+		for (u32 heard : room->heard)
+			idle = idle && tick - heard >= timeout;
+		if (!idle)
+			continue;
+
+		InputCommand leave{};
+		leave.type = INPUT_COMMAND_LEAVE;
+		for (const sockaddr_in& address : room->clients)
+		{
+			leave.from = address;
+			for (unsigned int i = 0; i < sCount; ++i)
+				InputQueuePush(sShards[i].inputs, leave);
+		}
+
+		std::cout << "CLOSED IDLE ROOM: " << static_cast<int>(room->id) << "\n";
+		RoomDestroy(*room);
+		closed = true;
+	}
+
+	if (closed)
+		ShardUpdateLoad(shard);
+}
+
+/******************************************************************************/
+/*!
+	Runs one shard until ShardsStop
+*/
+/******************************************************************************/
+static void ShardThread(Shard& shard)
+{
+	PlatformPinThread(shard.index);
+	SimClockReset();
+
+	ShardClock::duration const step = std::chrono::duration_cast<ShardClock::duration>(
+		std::chrono::duration<f64>(SimClockGetStep()));
+	ShardClock::time_point last = ShardClock::now();
+
+	while (sRunning)
+	{
+		// take datagrams as they come until the next tick is due, then what is
+		// already waiting. a shard behind its ticks would otherwise take one
+		// datagram a tick and the socket would drop the rest. at most one ring
+		// worth, the queue could not hold more anyway
+		ShardClock::time_point due = last + step;
+		for (unsigned int i = 0; i < INPUT_QUEUE_CAPACITY; ++i)
+		{
+			f64 wait = std::chrono::duration<f64>(due - ShardClock::now()).count();
+			if (!PlatformNetWait(shard.socket, wait))
+				break;
+			ShardReceive(shard);
+		}
+
+		// then apply all of it in the order it was queued, at most one ring
+		// worth so busy producers can not keep the tick waiting
+		InputCommand command;
+		for (unsigned int i = 0; i < INPUT_QUEUE_CAPACITY && InputQueuePop(shard.inputs, command); ++i)
+			ShardApply(shard, command);
+
+		ShardClock::time_point now = ShardClock::now();
+		unsigned int ticks = SimClockAdvance(std::chrono::duration<f64>(now - last).count());
+		last = now;
+		if (ticks == 0)
+			continue;
+
+		// only the last tick is sent, so only it is serialized
+		unsigned int rooms = RoomGetCount(shard.index);
+		for (unsigned int t = 0; t < ticks; ++t)
+		{
+			for (unsigned int r = 0; r < rooms; ++r)
+			{
+				Room* room = RoomGet(shard.index, r);
+				if (room)
+					RoomStep(*room, SimClockGetStep(), t + 1 == ticks);
+			}
+			SimClockStep();
+		}
+
+		ShardClock::time_point simulated = ShardClock::now();
+		shard.ticks.fetch_add(ticks);
+		shard.tickMicroseconds.fetch_add(static_cast<u64>(
+			std::chrono::duration_cast<std::chrono::microseconds>(simulated - now).count()));
+
+		unsigned int sent{};
+		u64 bytes{};
+		for (unsigned int r = 0; r < rooms; ++r)
+		{
+			Room* room = RoomGet(shard.index, r);
+			if (room)
+				sent += RoomSendSnapshot(*room, bytes);
+		}
+		shard.packetsOut.fetch_add(sent);
+		shard.bytesOut.fetch_add(bytes);
+
+		ShardCloseIdle(shard);
+	}
+}
+
+/******************************************************************************/
+/*!
+	Opening, running and closing the shards
+*/
+/******************************************************************************/
+int ShardsOpen(unsigned int count, const addrinfo* address)
+{
+	// only linux hands datagrams out by a program, elsewhere one socket
+	// takes everything
+#if defined(__linux__) && defined(SO_REUSEPORT)
+	if (count > SHARD_NUM_MAX)
+		count = SHARD_NUM_MAX;
+#else
+	count = 1;
+#endif
+	if (count == 0)
+		count = 1;
+
+	sCount = count;
+	sShards.reset(new Shard[count]());	// the counters start at 0
+
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		Shard& shard = sShards[i];
+		shard.index = i;
+		InputQueueInit(shard.inputs, INPUT_QUEUE_CAPACITY);
+		shard.socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (shard.socket == INVALID_SOCKET) {
+			std::cerr << "socket() failed." << std::endl;
+			ShardsStop();
+			return 1;
+		}
+
+#if defined(__linux__) && defined(SO_REUSEPORT)
+		// the sockets of a group are numbered in bind order, same as the shards
+		if (count > 1) {
+			int reuse = 1;
+			setsockopt(shard.socket, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
+		}
+#endif
+
+		int errorCode = bind(shard.socket, address->ai_addr, static_cast<int>(address->ai_addrlen));
+		if (errorCode != NO_ERROR) {
+			std::cerr << "bind() failed." << std::endl;
+			ShardsStop();
+			return 2;
+		}
+	}
+
+	if (count > 1)
+		ShardAttachSteering(sShards[0].socket);
+
+	return 0;
+}
+
+void ShardsStart()
+{
+	sRunning = true;
+	for (unsigned int i = 0; i < sCount; ++i)
+		sShards[i].thread = std::thread(ShardThread, std::ref(sShards[i]));
+}
+
+void ShardsStop()
+{
+	// a shard waits at most one tick on its socket before it sees this
+	sRunning = false;
+	for (unsigned int i = 0; i < sCount; ++i)
+	{
+		Shard& shard = sShards[i];
+		if (shard.thread.joinable())
+			shard.thread.join();
+		if (shard.socket != INVALID_SOCKET)
+			closesocket(shard.socket);
+	}
+
+	sShards.reset();
+	sCount = 0;
+}
+
+unsigned int ShardGetCount()
+{
+	return sCount;
+}
+
+void ShardGetStats(unsigned int shard, ShardStats& stats)
+{
+	const Shard& s = sShards[shard];
+	stats.rooms = s.rooms;
+	stats.players = s.players;
+	stats.openSeats = s.openSeats;
+	stats.ticks = s.ticks;
+	stats.tickMicroseconds = s.tickMicroseconds;
+	stats.packetsIn = s.packetsIn;
+	stats.packetsOut = s.packetsOut;
+	stats.bytesOut = s.bytesOut;
+	stats.forwarded = s.forwarded;
+	stats.dropped = s.inputs.dropped;
+}
+
+/******************************************************************************/
+/*!
+	Shard a new player goes to, the first with a free seat or else the
+	one with the fewest players
+*/
+/******************************************************************************/
+unsigned int ShardPick()
+{
+	unsigned int best = 0;
+	unsigned int bestPlayers = ~0u;
+
+	for (unsigned int i = 0; i < sCount; ++i)
+	{
+		Shard& shard = sShards[i];
+		if (shard.openSeats > 0) {
+			best = i;
+			break;
+		}
+		if (shard.players < bestPlayers) {
+			best = i;
+			bestPlayers = shard.players;
+		}
+	}
+
+	// counts the player before its join lands, so a burst of joins spreads
+	// out. the shard recounts once it took it
+	Shard& picked = sShards[best];
+	unsigned int seats = picked.openSeats;
+	if (seats > 0)
+		picked.openSeats.compare_exchange_strong(seats, seats - 1);
+	picked.players.fetch_add(1);
+
+	return best;
+}
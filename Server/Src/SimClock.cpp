@@ -0,0 +1,88 @@
+/******************************************************************************/
+/*!
+\file			SimClock.cpp
+\author
+\par
+\date
+\brief		This is the simulation clock source file. The frame time is only
+					ever added to an accumulator, the simulation itself always steps
+					by the same dt so ticks are reproducible whatever the frame rate.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "SimClock.h"
+
+static unsigned int	sTickRate;		// ticks per second
+static f64					sStep;				// seconds per tick
+
+// every thread that runs rooms keeps its own time
+static thread_local f64	sAccumulator;	// frame time not simulated yet
+static thread_local u32	sTick;				// number of the next tick to simulate
+
+/******************************************************************************/
+/*!
+	Sets the tick rate, the clock starts at tick 0
+*/
+/******************************************************************************/
+void SimClockInit(unsigned int tickRate)
+{
+	sTickRate = tickRate ? tickRate : SIM_TICK_RATE_DEFAULT;
+	sStep = 1.0 / static_cast<f64>(sTickRate);
+	SimClockReset();
+}
+
+void SimClockReset()
+{
+	sAccumulator = 0.0;
+	sTick = 0;
+}
+
+/******************************************************************************/
+/*!
+	Adds a frame of real time and returns how many ticks are due
+*/
+/******************************************************************************/
+unsigned int SimClockAdvance(f64 frameTime)
+{
+	sAccumulator += frameTime;
+
+	unsigned int ticks = static_cast<unsigned int>(sAccumulator / sStep);
+
+	// a long stall would otherwise make the server run ticks back to back forever
+	if (ticks > SIM_TICKS_PER_FRAME_MAX) {
+		ticks = SIM_TICKS_PER_FRAME_MAX;
+		sAccumulator = sStep * ticks;
+	}
+
+	return ticks;
+}
+
+/******************************************************************************/
+/*!
+	Tick counter and length
+*/
+/******************************************************************************/
+void SimClockStep()
+{
+	sAccumulator -= sStep;
+	++sTick;
+}
+
+f32 SimClockGetStep()
+{
+	return static_cast<f32>(sStep);
+}
+
+unsigned int SimClockGetTickRate()
+{
+	return sTickRate;
+}
+
+u32 SimClockGetTick()
+{
+	return sTick;
+}
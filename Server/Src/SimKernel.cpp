@@ -0,0 +1,261 @@
+/******************************************************************************/
+/*!
+\file			SimKernel.cpp
+\author
+\par
+\date
+\brief		This is the simulation kernel source file. The SIMD versions do
+					the same operations in the same order as the scalar one and pick
+					wrapped lanes with bit masks, so they round exactly like it.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "SimKernel.h"
+
+#if defined(SIM_KERNEL_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/******************************************************************************/
+/*!
+	Static Variables
+*/
+/******************************************************************************/
+static SIM_KERNEL_ISA sIsa = SIM_KERNEL_SCALAR;
+
+/******************************************************************************/
+/*!
+	One row at a time, also finishes the rows left over by the SIMD versions
+*/
+/******************************************************************************/
+static inline f32 SimWrap(f32 x, f32 x0, f32 x1)
+{
+	f32 range = x1 - x0;
+
+	if (x < x0)
+		return x + range;
+	if (x > x1)
+		return x - range;
+
+	return x;
+}
+
+static void SimKernelScalar(EntityStore& e, unsigned int begin, unsigned int end,
+														f32 dt, f32 halfExtent, const SimBounds& b)
+{
+	for (unsigned int i = begin; i < end; i++)
+	{
+		f32 halfSize = halfExtent * e.scale[i];
+
+		e.minX[i] = e.posX[i] - halfSize;
+		e.minY[i] = e.posY[i] - halfSize;
+
+		e.maxX[i] = e.posX[i] + halfSize;
+		e.maxY[i] = e.posY[i] + halfSize;
+
+		f32 x = e.velX[i] * dt + e.posX[i];
+		f32 y = e.velY[i] * dt + e.posY[i];
+
+		f32 margin = e.wrapMargin[i];
+		e.posX[i] = SimWrap(x, b.minX - margin, b.maxX + margin);
+		e.posY[i] = SimWrap(y, b.minY - margin, b.maxY + margin);
+	}
+}
+
+#ifdef SIM_KERNEL_X86
+
+/******************************************************************************/
+/*!
+	4 rows at a time
+*/
+/******************************************************************************/
+static inline __m128 SimWrapSSE2(__m128 x, __m128 x0, __m128 x1)
+{
+	__m128 range	= _mm_sub_ps(x1, x0);
+	__m128 below	= _mm_cmplt_ps(x, x0);
+	__m128 above	= _mm_cmpgt_ps(x, x1);
+
+	// an infinite margin gives an infinite range, its lanes are never selected
+	x = _mm_or_ps(_mm_and_ps(below, _mm_add_ps(x, range)), _mm_andnot_ps(below, x));
+	x = _mm_or_ps(_mm_and_ps(above, _mm_sub_ps(x, range)), _mm_andnot_ps(above, x));
+
+	return x;
+}
+
+static unsigned int SimKernelSSE2(EntityStore& e, unsigned int begin, unsigned int end,
+																	f32 dt, f32 halfExtent, const SimBounds& b)
+{
+	const __m128 vDt		= _mm_set1_ps(dt);
+	const __m128 vHalf	= _mm_set1_ps(halfExtent);
+	const __m128 vMinX	= _mm_set1_ps(b.minX);
+	const __m128 vMaxX	= _mm_set1_ps(b.maxX);
+	const __m128 vMinY	= _mm_set1_ps(b.minY);
+	const __m128 vMaxY	= _mm_set1_ps(b.maxY);
+
+	unsigned int i = begin;
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 px = _mm_loadu_ps(&e.posX[i]);
+		__m128 py = _mm_loadu_ps(&e.posY[i]);
+		__m128 halfSize = _mm_mul_ps(vHalf, _mm_loadu_ps(&e.scale[i]));
+
+		_mm_storeu_ps(&e.minX[i], _mm_sub_ps(px, halfSize));
+		_mm_storeu_ps(&e.minY[i], _mm_sub_ps(py, halfSize));
+		_mm_storeu_ps(&e.maxX[i], _mm_add_ps(px, halfSize));
+		_mm_storeu_ps(&e.maxY[i], _mm_add_ps(py, halfSize));
+
+		px = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&e.velX[i]), vDt), px);
+		py = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&e.velY[i]), vDt), py);
+
+		__m128 margin = _mm_loadu_ps(&e.wrapMargin[i]);
+		px = SimWrapSSE2(px, _mm_sub_ps(vMinX, margin), _mm_add_ps(vMaxX, margin));
+		py = SimWrapSSE2(py, _mm_sub_ps(vMinY, margin), _mm_add_ps(vMaxY, margin));
+
+		_mm_storeu_ps(&e.posX[i], px);
+		_mm_storeu_ps(&e.posY[i], py);
+	}
+
+	return i;
+}
+
+/******************************************************************************/
+/*!
+	8 rows at a time
+*/
+/******************************************************************************/
+SIM_KERNEL_TARGET_AVX2
+static inline __m256 SimWrapAVX2(__m256 x, __m256 x0, __m256 x1)
+{
+	__m256 range	= _mm256_sub_ps(x1, x0);
+	__m256 below	= _mm256_cmp_ps(x, x0, _CMP_LT_OQ);
+	__m256 above	= _mm256_cmp_ps(x, x1, _CMP_GT_OQ);
+
+	x = _mm256_blendv_ps(x, _mm256_add_ps(x, range), below);
+	x = _mm256_blendv_ps(x, _mm256_sub_ps(x, range), above);
+
+	return x;
+}
+
+SIM_KERNEL_TARGET_AVX2
+static unsigned int SimKernelAVX2(EntityStore& e, unsigned int begin, unsigned int end,
+																	f32 dt, f32 halfExtent, const SimBounds& b)
+{
+	const __m256 vDt		= _mm256_set1_ps(dt);
+	const __m256 vHalf	= _mm256_set1_ps(halfExtent);
+	const __m256 vMinX	= _mm256_set1_ps(b.minX);
+	const __m256 vMaxX	= _mm256_set1_ps(b.maxX);
+	const __m256 vMinY	= _mm256_set1_ps(b.minY);
+	const __m256 vMaxY	= _mm256_set1_ps(b.maxY);
+
+	unsigned int i = begin;
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 px = _mm256_loadu_ps(&e.posX[i]);
+		__m256 py = _mm256_loadu_ps(&e.posY[i]);
+		__m256 halfSize = _mm256_mul_ps(vHalf, _mm256_loadu_ps(&e.scale[i]));
+
+		_mm256_storeu_ps(&e.minX[i], _mm256_sub_ps(px, halfSize));
+		_mm256_storeu_ps(&e.minY[i], _mm256_sub_ps(py, halfSize));
+		_mm256_storeu_ps(&e.maxX[i], _mm256_add_ps(px, halfSize));
+		_mm256_storeu_ps(&e.maxY[i], _mm256_add_ps(py, halfSize));
+
+		// separate multiply and add, a fused one would round differently from the scalar path
+		px = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&e.velX[i]), vDt), px);
+		py = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&e.velY[i]), vDt), py);
+
+		__m256 margin = _mm256_loadu_ps(&e.wrapMargin[i]);
+		px = SimWrapAVX2(px, _mm256_sub_ps(vMinX, margin), _mm256_add_ps(vMaxX, margin));
+		py = SimWrapAVX2(py, _mm256_sub_ps(vMinY, margin), _mm256_add_ps(vMaxY, margin));
+
+		_mm256_storeu_ps(&e.posX[i], px);
+		_mm256_storeu_ps(&e.posY[i], py);
+	}
+
+	return i;
+}
+
+/******************************************************************************/
+/*!
+	True when the cpu and the os both support AVX2
+*/
+/******************************************************************************/
+static bool SimKernelCpuHasAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	__cpuid(info, 1);
+	bool osxsave	= (info[2] & (1 << 27)) != 0;
+	bool avx			= (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // SIM_KERNEL_X86
+
+/******************************************************************************/
+/*!
+	Picking the instruction set
+*/
+/******************************************************************************/
+void SimKernelInit(SIM_KERNEL_ISA maxIsa)
+{
+	sIsa = SIM_KERNEL_SCALAR;
+
+#ifdef SIM_KERNEL_X86
+	// every x86 target this builds for has SSE2
+	if (maxIsa >= SIM_KERNEL_SSE2)
+		sIsa = SIM_KERNEL_SSE2;
+	if (maxIsa >= SIM_KERNEL_AVX2 && SimKernelCpuHasAVX2())
+		sIsa = SIM_KERNEL_AVX2;
+#else
+	UNREFERENCED_PARAMETER(maxIsa);
+#endif
+}
+
+SIM_KERNEL_ISA SimKernelGetIsa()
+{
+	return sIsa;
+}
+
+const char* SimKernelGetIsaName(SIM_KERNEL_ISA isa)
+{
+	switch (isa)
+	{
+	case SIM_KERNEL_SSE2:	return "sse2";
+	case SIM_KERNEL_AVX2:	return "avx2";
+	default:							return "scalar";
+	}
+}
+
+/******************************************************************************/
+/*!
+	Runs the picked version, the scalar one finishes the rows left over
+*/
+/******************************************************************************/
+void SimKernelIntegrateWrap(EntityStore& store, unsigned int begin, unsigned int end,
+														f32 dt, f32 halfExtent, const SimBounds& bounds)
+{
+#ifdef SIM_KERNEL_X86
+	if (sIsa == SIM_KERNEL_AVX2)
+		begin = SimKernelAVX2(store, begin, end, dt, halfExtent, bounds);
+	if (sIsa >= SIM_KERNEL_SSE2)
+		begin = SimKernelSSE2(store, begin, end, dt, halfExtent, bounds);
+#endif
+
+	SimKernelScalar(store, begin, end, dt, halfExtent, bounds);
+}
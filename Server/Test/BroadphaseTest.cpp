@@ -0,0 +1,219 @@
+/******************************************************************************/
+/*!
+\file			BroadphaseTest.cpp
+\author
+\par
+\date
+\brief		This is the broadphase test. It moves seeded worlds tick by tick
+					and checks that the grid and the sort and sweep backends hand out
+					exactly the pairs brute force does, offsets included, on crowds,
+					on entities sitting on and past the wrap edges and while
+					entities come and go, which reshuffles the sort and sweep order.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "GameState_Asteroids.h"
+#include "Broadphase.h"
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+const f32						TEST_DT = 1.0f / 60.0f;
+const unsigned int	TEST_TICKS = 30;
+const SimBounds			TEST_BOUNDS{ -400.0f, 400.0f, -300.0f, 300.0f };
+
+/******************************************************************************/
+/*!
+	Static Variables
+*/
+/******************************************************************************/
+static unsigned int sFailures;
+
+/******************************************************************************/
+/*!
+	Adds an entity of type at pos moving along vel, with the size and wrap
+	margin the game gives that type
+*/
+/******************************************************************************/
+static EntityHandle TestAdd(EntityStore& store, unsigned long type, AEVec2 pos, AEVec2 vel)
+{
+	const f32 scales[TYPE_NUM] = { SHIP_SIZE, BULLET_SIZE, ASTEROID_SIZE };
+	const f32 margins[TYPE_NUM] = { SHIP_SIZE, std::numeric_limits<f32>::infinity(), BOUNDING_RECT_SIZE * ASTEROID_SIZE };
+
+	EntityHandle h = EntityCreate(store, type, scales[type], &pos, &vel, 0.0f);
+	if (h != ENTITY_INVALID)
+		store.wrapMargin[EntityRow(store, h)] = margins[type];
+	return h;
+}
+
+/******************************************************************************/
+/*!
+	Runs every backend on the store as it is and compares each with brute
+	force, pair by pair
+*/
+/******************************************************************************/
+static void TestCompare(const char* name, unsigned int tick, const EntityStore& store,
+	BroadphaseContext* contexts[BROADPHASE_TYPE_NUM])
+{
+	std::vector<unsigned int> queries, targets;
+	for (unsigned int i = 0; i < store.count; i++)
+		(store.type[i] == TYPE_ASTEROID ? queries : targets).push_back(i);
+
+	std::vector<BroadphasePair> pairs[BROADPHASE_TYPE_NUM];
+	for (unsigned int type = 0; type < BROADPHASE_TYPE_NUM; type++)
+	{
+		BroadphaseInit(static_cast<BROADPHASE_TYPE>(type), ASTEROID_SIZE);
+		BroadphaseFindPairs(*contexts[type], store, TEST_DT, TEST_BOUNDS, queries, targets, pairs[type]);
+	}
+
+	const std::vector<BroadphasePair>& expected = pairs[BROADPHASE_BRUTE];
+	for (unsigned int type = BROADPHASE_BRUTE + 1; type < BROADPHASE_TYPE_NUM; type++)
+	{
+		const std::vector<BroadphasePair>& got = pairs[type];
+		const char* backend = BroadphaseGetTypeName(static_cast<BROADPHASE_TYPE>(type));
+
+		if (got.size() != expected.size() && sFailures++ < 20) {
+			std::cerr << name << " tick " << tick << " " << backend << ": " << got.size()
+				<< " pairs, brute force has " << expected.size() << "\n";
+			continue;
+		}
+
+		for (size_t p = 0; p < got.size(); p++)
+		{
+			const BroadphasePair& a = got[p];
+			const BroadphasePair& b = expected[p];
+			if ((a.query != b.query || a.target != b.target || a.offset.x != b.offset.x || a.offset.y != b.offset.y)
+				&& sFailures++ < 20) {
+				std::cerr << name << " tick " << tick << " " << backend << " pair " << p << ": got ("
+					<< a.query << "," << a.target << "," << a.offset.x << "," << a.offset.y << ") expected ("
+					<< b.query << "," << b.target << "," << b.offset.x << "," << b.offset.y << ")\n";
+				break;
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+	Moves the world TEST_TICKS ticks and compares the backends on each one,
+	the same contexts all along so the grid and sort and sweep keep their
+	state between ticks. churn destroys and adds a few bullets every tick
+*/
+/******************************************************************************/
+static void TestRun(const char* name, EntityStore& store, std::mt19937& random, bool churn)
+{
+	BroadphaseContext* contexts[BROADPHASE_TYPE_NUM];
+	for (unsigned int type = 0; type < BROADPHASE_TYPE_NUM; type++)
+	{
+		BroadphaseInit(static_cast<BROADPHASE_TYPE>(type), ASTEROID_SIZE);
+		contexts[type] = BroadphaseCreate();
+	}
+
+	std::uniform_real_distribution<f32> x(TEST_BOUNDS.minX, TEST_BOUNDS.maxX);
+	std::uniform_real_distribution<f32> y(TEST_BOUNDS.minY, TEST_BOUNDS.maxY);
+	std::uniform_real_distribution<f32> v(-BULLET_SPEED, BULLET_SPEED);
+
+	for (unsigned int tick = 0; tick < TEST_TICKS; tick++)
+	{
+		SimKernelIntegrateWrap(store, 0, store.count, TEST_DT, BOUNDING_RECT_SIZE / 2.0f, TEST_BOUNDS);
+		TestCompare(name, tick, store, contexts);
+
+		for (unsigned int n = 0; churn && n < 8; n++)
+		{
+			unsigned int row = static_cast<unsigned int>(random() % store.count);
+			if (store.type[row] == TYPE_BULLET)
+				EntityDestroy(store, EntityHandleOfRow(store, row));
+			TestAdd(store, TYPE_BULLET, { x(random), y(random) }, { v(random), v(random) });
+		}
+	}
+
+	for (BroadphaseContext* context : contexts)
+		BroadphaseDestroy(context);
+}
+
+/******************************************************************************/
+/*!
+	Asteroids and bullets anywhere, half the bullets bunched up
+*/
+/******************************************************************************/
+static void TestCrowd(bool churn)
+{
+	std::mt19937 random(1130);
+	std::uniform_real_distribution<f32> x(TEST_BOUNDS.minX, TEST_BOUNDS.maxX);
+	std::uniform_real_distribution<f32> y(TEST_BOUNDS.minY, TEST_BOUNDS.maxY);
+	std::uniform_real_distribution<f32> v(-BULLET_SPEED, BULLET_SPEED);
+	std::normal_distribution<f32> spread(0.0f, 2.0f * SHIP_SIZE);
+
+	EntityStore store;
+	EntityStoreInit(store, 2048);
+	for (unsigned int i = 0; i < 8; i++)
+		TestAdd(store, TYPE_SHIP, { x(random), y(random) }, { v(random), v(random) });
+	for (unsigned int i = 0; i < 60; i++)
+		TestAdd(store, TYPE_ASTEROID, { x(random), y(random) }, { v(random) / 3.0f, v(random) / 3.0f });
+	for (unsigned int i = 0; i < 1200; i++)
+	{
+		AEVec2 pos{ x(random), y(random) };
+		if (i % 2 == 0)
+			pos = { 100.0f + spread(random), -50.0f + spread(random) };
+		TestAdd(store, TYPE_BULLET, pos, { v(random), v(random) });
+	}
+
+	TestRun(churn ? "crowd churn" : "crowd", store, random, churn);
+}
+
+/******************************************************************************/
+/*!
+	Everything starts on a wrap edge, a corner, just inside or just past
+	one, so every kind of ghost is made
+*/
+/******************************************************************************/
+static void TestEdges()
+{
+	std::mt19937 random(2250);
+	std::uniform_real_distribution<f32> v(-ASTEROID_SPEED * 2.0f, ASTEROID_SPEED * 2.0f);
+	std::uniform_real_distribution<f32> jitter(-ASTEROID_SIZE, ASTEROID_SIZE);
+
+	const SimBounds& b = TEST_BOUNDS;
+	const f32 margin = BOUNDING_RECT_SIZE * ASTEROID_SIZE;
+	const f32 xs[] = { b.minX - margin, b.minX, 0.0f, b.maxX, b.maxX + margin };
+	const f32 ys[] = { b.minY - margin, b.minY, 0.0f, b.maxY, b.maxY + margin };
+
+	EntityStore store;
+	EntityStoreInit(store, 2048);
+	for (f32 px : xs)
+	{
+		for (f32 py : ys)
+		{
+			TestAdd(store, TYPE_ASTEROID, { px, py }, { v(random), v(random) });
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				TestAdd(store, TYPE_SHIP, { px + jitter(random), py + jitter(random) }, { v(random), v(random) });
+				TestAdd(store, TYPE_BULLET, { px + jitter(random), py + jitter(random) }, { v(random), v(random) });
+			}
+		}
+	}
+
+	TestRun("edges", store, random, false);
+}
+
+int main()
+{
+	SimKernelInit();
+
+	TestCrowd(false);
+	TestCrowd(true);
+	TestEdges();
+
+	std::cout << (sFailures == 0 ? "grid and sap match brute force\n" : "FAILED\n");
+	return sFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+/******************************************************************************/
+/*!
+\file			CollisionTest.cpp
+\author
+\par
+\date
+\brief		This is the collision test. It runs CollisionIntersection_RectRectBatch
+					on every instruction set the cpu has and checks every candidate
+					against CollisionIntersection_RectRect, on random boxes laid on
+					a coarse grid so edges touch and velocities cancel often, and on
+					a list of hand picked edge cases.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "Collision.h"
+#include "SimKernel.h"
+#include <iostream>
+#include <random>
+#include <vector>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+const float					TEST_DT = 1.0f / 60.0f;
+const unsigned int	TEST_RANDOM_BATCHES = 20000;
+
+// candidates of one batch, same layout the room packs them in
+struct TestBatch
+{
+	std::vector<float>					minX, minY, maxX, maxY, velX, velY;
+	std::vector<unsigned char>	hits;
+
+	void Add(const AABB& box, const AEVec2& vel)
+	{
+		minX.push_back(box.min.x); minY.push_back(box.min.y);
+		maxX.push_back(box.max.x); maxY.push_back(box.max.y);
+		velX.push_back(vel.x); velY.push_back(vel.y);
+		hits.push_back(0xCD);
+	}
+};
+
+/******************************************************************************/
+/*!
+	Static Variables
+*/
+/******************************************************************************/
+static unsigned int sFailures;
+
+/******************************************************************************/
+/*!
+	Runs the batch on the current instruction set and compares every hit and
+	the count with the scalar version
+*/
+/******************************************************************************/
+static void TestCheck(const char* name, const AABB& aabb1, const AEVec2& vel1, TestBatch& batch, float dt)
+{
+	unsigned int count = static_cast<unsigned int>(batch.minX.size());
+	unsigned int hitCount = CollisionIntersection_RectRectBatch(aabb1, vel1,
+		batch.minX.data(), batch.minY.data(), batch.maxX.data(), batch.maxY.data(),
+		batch.velX.data(), batch.velY.data(), count, dt, batch.hits.data());
+
+	unsigned int expectedCount = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		AABB		aabb2{ { batch.minX[i], batch.minY[i] }, { batch.maxX[i], batch.maxY[i] } };
+		AEVec2	vel2{ batch.velX[i], batch.velY[i] };
+		unsigned char expected = CollisionIntersection_RectRect(aabb1, vel1, aabb2, vel2, dt) ? 1 : 0;
+		expectedCount += expected;
+
+		if (batch.hits[i] != expected && sFailures++ < 20) {
+			std::cerr << SimKernelGetIsaName(SimKernelGetIsa()) << " " << name << " candidate " << i
+				<< ": got " << static_cast<int>(batch.hits[i]) << " expected " << static_cast<int>(expected)
+				<< " for (" << aabb1.min.x << "," << aabb1.min.y << ")-(" << aabb1.max.x << "," << aabb1.max.y
+				<< ") v(" << vel1.x << "," << vel1.y << ") against (" << aabb2.min.x << "," << aabb2.min.y
+				<< ")-(" << aabb2.max.x << "," << aabb2.max.y << ") v(" << vel2.x << "," << vel2.y << ")\n";
+		}
+	}
+
+	if (hitCount != expectedCount && sFailures++ < 20)
+		std::cerr << SimKernelGetIsaName(SimKernelGetIsa()) << " " << name << ": " << hitCount
+			<< " hits counted, " << expectedCount << " expected\n";
+}
+
+/******************************************************************************/
+/*!
+	Cases picked by hand, one box against every kind of second box. The boxes
+	are 1 wide and the velocities move them 1 per tick, so every contact time
+	lands exactly on 0 or dt
+*/
+/******************************************************************************/
+static void TestEdgeCases()
+{
+	const float v = 1.0f / TEST_DT;
+	AABB		aabb1{ { 0.0f, 0.0f }, { 1.0f, 1.0f } };
+	AEVec2	still{ 0.0f, 0.0f };
+	TestBatch batch;
+
+	// overlapping, and touching on every edge and corner
+	batch.Add({ { 0.5f, 0.5f }, { 1.5f, 1.5f } }, still);
+	batch.Add({ { 1.0f, 0.0f }, { 2.0f, 1.0f } }, still);
+	batch.Add({ { -1.0f, 0.0f }, { 0.0f, 1.0f } }, still);
+	batch.Add({ { 0.0f, 1.0f }, { 1.0f, 2.0f } }, still);
+	batch.Add({ { 0.0f, -1.0f }, { 1.0f, 0.0f } }, still);
+	batch.Add({ { 1.0f, 1.0f }, { 2.0f, 2.0f } }, still);
+	batch.Add({ { 0.0f, 0.0f }, { 1.0f, 1.0f } }, still);
+	batch.Add({ { 0.5f, 0.5f }, { 0.5f, 0.5f } }, still);			// a point inside
+
+	// apart with no relative motion on the apart axis, vb == 0 there
+	batch.Add({ { 2.0f, 0.0f }, { 3.0f, 1.0f } }, { 0.0f, v });
+	batch.Add({ { 0.0f, 2.0f }, { 1.0f, 3.0f } }, { v, 0.0f });
+	batch.Add({ { -3.0f, 0.0f }, { -2.0f, 1.0f } }, { 0.0f, -v });
+	batch.Add({ { 0.0f, -3.0f }, { 1.0f, -2.0f } }, { -v, 0.0f });
+	batch.Add({ { 2.0f, 2.0f }, { 3.0f, 3.0f } }, still);
+
+	// apart and moving away, on each side
+	batch.Add({ { 2.0f, 0.0f }, { 3.0f, 1.0f } }, { v, 0.0f });
+	batch.Add({ { -3.0f, 0.0f }, { -2.0f, 1.0f } }, { -v, 0.0f });
+	batch.Add({ { 0.0f, 2.0f }, { 1.0f, 3.0f } }, { 0.0f, v });
+	batch.Add({ { 0.0f, -3.0f }, { 1.0f, -2.0f } }, { 0.0f, -v });
+
+	// apart and closing, touching exactly at dt, meeting before it, short of it
+	batch.Add({ { 2.0f, 0.0f }, { 3.0f, 1.0f } }, { -v, 0.0f });
+	batch.Add({ { 2.0f, 0.0f }, { 3.0f, 1.0f } }, { -2.0f * v, 0.0f });
+	batch.Add({ { 2.0f, 0.0f }, { 3.0f, 1.0f } }, { -0.5f * v, 0.0f });
+	batch.Add({ { -3.0f, 0.0f }, { -2.0f, 1.0f } }, { v, 0.0f });
+	batch.Add({ { 0.0f, -3.0f }, { 1.0f, -2.0f } }, { 0.0f, 2.0f * v });
+
+	// apart on both axes, closing on both, one of them too late
+	batch.Add({ { 2.0f, 2.0f }, { 3.0f, 3.0f } }, { -2.0f * v, -2.0f * v });
+	batch.Add({ { 2.0f, 3.0f }, { 3.0f, 4.0f } }, { -2.0f * v, -v });
+	batch.Add({ { 2.0f, 2.0f }, { 3.0f, 3.0f } }, { -2.0f * v, 0.0f });
+
+	// passing straight through within the tick
+	batch.Add({ { 2.0f, 0.25f }, { 2.5f, 0.75f } }, { -4.0f * v, 0.0f });
+
+	TestCheck("edge", aabb1, still, batch, TEST_DT);
+
+	// the same cases with the first box moving instead, and with no time at all
+	TestBatch moving;
+	for (size_t i = 0; i < batch.minX.size(); i++)
+	{
+		moving.Add({ { batch.minX[i], batch.minY[i] }, { batch.maxX[i], batch.maxY[i] } },
+			{ batch.velX[i] + 3.0f, batch.velY[i] - 2.0f });
+	}
+	TestCheck("edge moving", aabb1, { 3.0f, -2.0f }, moving, TEST_DT);
+	TestCheck("edge no time", aabb1, still, batch, 0.0f);
+}
+
+/******************************************************************************/
+/*!
+	Boxes with corners on a half unit grid and velocities in whole units per
+	tick, every count from 0 to 19 candidates so the tails are covered too
+*/
+/******************************************************************************/
+static void TestRandom()
+{
+	std::mt19937 random(1130);
+	std::uniform_int_distribution<int> corner(-8, 8);
+	std::uniform_int_distribution<int> size(0, 6);
+	std::uniform_int_distribution<int> speed(-3, 3);
+
+	auto randomBox = [&]() {
+		float x = corner(random) * 0.5f, y = corner(random) * 0.5f;
+		return AABB{ { x, y }, { x + size(random) * 0.5f, y + size(random) * 0.5f } };
+	};
+	auto randomVel = [&]() {
+		return AEVec2{ speed(random) / TEST_DT, speed(random) / TEST_DT };
+	};
+
+	for (unsigned int b = 0; b < TEST_RANDOM_BATCHES; b++)
+	{
+		AABB		aabb1 = randomBox();
+		AEVec2	vel1 = randomVel();
+		TestBatch batch;
+		for (unsigned int c = b % 20; c > 0; c--)
+			batch.Add(randomBox(), randomVel());
+
+		TestCheck("random", aabb1, vel1, batch, TEST_DT);
+	}
+}
+
+int main()
+{
+	const SIM_KERNEL_ISA isas[] = { SIM_KERNEL_SCALAR, SIM_KERNEL_SSE2, SIM_KERNEL_AVX2 };
+	for (SIM_KERNEL_ISA isa : isas)
+	{
+		SimKernelInit(isa);
+		if (SimKernelGetIsa() != isa) {
+			std::cout << SimKernelGetIsaName(isa) << ": not supported here, skipped\n";
+			continue;
+		}
+
+		unsigned int failures = sFailures;
+		TestEdgeCases();
+		TestRandom();
+		std::cout << SimKernelGetIsaName(isa) << ": " << (sFailures == failures ? "ok" : "FAILED") << "\n";
+	}
+
+	return sFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+/******************************************************************************/
+/*!
+\file			NarrowphaseTest.cpp
+\author
+\par
+\date
+\brief		This is the narrowphase test. It moves the same seeded crowd
+					tick by tick with no job workers and with several, runs
+					DetectCollisions on the pairs of every tick and checks every
+					worker count finds the same events in the same order as the
+					single threaded run.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "Room.h"
+#include "Narrowphase.h"
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+const f32						TEST_DT = 1.0f / 60.0f;
+const unsigned int	TEST_TICKS = 20;
+const SimBounds			TEST_BOUNDS{ -400.0f, 400.0f, -300.0f, 300.0f };
+
+/******************************************************************************/
+/*!
+	Static Variables
+*/
+/******************************************************************************/
+static unsigned int sFailures;
+
+/******************************************************************************/
+/*!
+	The same crowd every time: asteroids and ships anywhere, bullets bunched
+	up in a few spots so some asteroids have many candidates and most few
+*/
+/******************************************************************************/
+static void TestFill(Room& room)
+{
+	std::mt19937 random(1130);
+	std::uniform_real_distribution<f32> x(TEST_BOUNDS.minX, TEST_BOUNDS.maxX);
+	std::uniform_real_distribution<f32> y(TEST_BOUNDS.minY, TEST_BOUNDS.maxY);
+	std::uniform_real_distribution<f32> heading(-PI, PI);
+	std::normal_distribution<f32> spread(0.0f, ASTEROID_SIZE);
+	const f32 margins[TYPE_NUM] = { SHIP_SIZE, std::numeric_limits<f32>::infinity(), BOUNDING_RECT_SIZE * ASTEROID_SIZE };
+
+	EntityStoreInit(room.store, 4096);
+	auto add = [&](unsigned long type, f32 size, f32 speed, AEVec2 pos) {
+		f32 dir = heading(random);
+		AEVec2 vel{ cosf(dir) * speed, sinf(dir) * speed };
+		EntityHandle h = EntityCreate(room.store, type, size, &pos, &vel, dir);
+		room.store.wrapMargin[EntityRow(room.store, h)] = margins[type];
+	};
+
+	for (unsigned int i = 0; i < 16; i++)
+		add(TYPE_SHIP, SHIP_SIZE, 0.0f, { x(random), y(random) });
+	for (unsigned int i = 0; i < 200; i++)
+		add(TYPE_ASTEROID, ASTEROID_SIZE, ASTEROID_SPEED, { x(random), y(random) });
+	for (unsigned int i = 0; i < 3000; i++)
+	{
+		AEVec2 spot{ (i % 3) * 200.0f - 200.0f, (i % 2) * 150.0f - 75.0f };
+		add(TYPE_BULLET, BULLET_SIZE, BULLET_SPEED, { spot.x + spread(random), spot.y + spread(random) });
+	}
+}
+
+/******************************************************************************/
+/*!
+	Runs TEST_TICKS ticks of the crowd with workerCount job workers and
+	returns the events of all of them, a tick's events after the last one's
+*/
+/******************************************************************************/
+static std::vector<CollisionEvent> TestRun(unsigned int workerCount)
+{
+	JobSystemInit(workerCount);
+	BroadphaseInit(BROADPHASE_GRID, ASTEROID_SIZE);
+
+	Room room{};
+	room.broadphase = BroadphaseCreate();
+	TestFill(room);
+
+	std::vector<CollisionEvent> events;
+	for (unsigned int tick = 0; tick < TEST_TICKS; tick++)
+	{
+		EntityStore& e = room.store;
+		SimKernelIntegrateWrap(e, 0, e.count, TEST_DT, BOUNDING_RECT_SIZE / 2.0f, TEST_BOUNDS);
+
+		room.asteroidScratch.clear();
+		room.targetScratch.clear();
+		for (unsigned int i = 0; i < e.count; i++)
+			(e.type[i] == TYPE_ASTEROID ? room.asteroidScratch : room.targetScratch).push_back(i);
+		BroadphaseFindPairs(*room.broadphase, e, TEST_DT, TEST_BOUNDS, room.asteroidScratch, room.targetScratch, room.pairScratch);
+
+		DetectCollisions(room, TEST_DT);
+		events.insert(events.end(), room.eventScratch.begin(), room.eventScratch.end());
+	}
+
+	BroadphaseDestroy(room.broadphase);
+	JobSystemExit();
+	return events;
+}
+
+int main()
+{
+	SimKernelInit();
+
+	std::vector<CollisionEvent> expected = TestRun(0);
+	std::cout << expected.size() << " events without workers\n";
+	if (expected.empty()) {
+		std::cerr << "the crowd never collides, nothing is compared\n";
+		sFailures++;
+	}
+
+	const unsigned int workerCounts[] = { 1, 3, 7, 15 };
+	for (unsigned int workers : workerCounts)
+	{
+		std::vector<CollisionEvent> got = TestRun(workers);
+
+		unsigned int failures = sFailures;
+		if (got.size() != expected.size()) {
+			std::cerr << workers << " workers: " << got.size() << " events, " << expected.size() << " without workers\n";
+			sFailures++;
+		}
+		for (size_t i = 0; i < got.size() && i < expected.size() && sFailures == failures; i++)
+		{
+			if (got[i].asteroid != expected[i].asteroid || got[i].target != expected[i].target) {
+				std::cerr << workers << " workers, event " << i << ": got (" << got[i].asteroid << "," << got[i].target
+					<< ") expected (" << expected[i].asteroid << "," << expected[i].target << ")\n";
+				sFailures++;
+			}
+		}
+		std::cout << workers << " workers: " << (sFailures == failures ? "ok" : "FAILED") << "\n";
+	}
+
+	return sFailures == 0 ? 0 : 1;
+}
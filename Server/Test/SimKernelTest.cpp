@@ -0,0 +1,203 @@
+/******************************************************************************/
+/*!
+\file			SimKernelTest.cpp
+\author
+\par
+\date
+\brief		This is the simulation kernel test. It runs SimKernelIntegrateWrap
+					on every instruction set the cpu has over the same rows and
+					checks the bounding boxes and positions come out bit for bit
+					like the scalar loop, for every row count and start up to a few
+					vectors wide and for positions on, just inside and just past
+					the wrap bounds.
+
+Copyright (C) 2024 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the
+prior written consent of DigiPen Institute of Technology is prohibited.
+ */
+/******************************************************************************/
+
+#include "SimKernel.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+
+/******************************************************************************/
+/*!
+	Defines
+*/
+/******************************************************************************/
+const unsigned int	TEST_ROWS = 64;
+const f32						TEST_HALF_EXTENT = 0.5f;
+const SimBounds			TEST_BOUNDS{ -400.0f, 400.0f, -300.0f, 300.0f };
+
+/******************************************************************************/
+/*!
+	Static Variables
+*/
+/******************************************************************************/
+static unsigned int sFailures;
+
+/******************************************************************************/
+/*!
+	Same bits, so -0 and 0 differ and nothing is let through by a tolerance
+*/
+/******************************************************************************/
+static bool TestSame(f32 a, f32 b)
+{
+	return std::memcmp(&a, &b, sizeof(f32)) == 0;
+}
+
+static void TestCompare(const char* name, const char* field, unsigned int row,
+	const std::vector<float>& got, const std::vector<float>& expected)
+{
+	if (!TestSame(got[row], expected[row]) && sFailures++ < 20) {
+		std::cerr.precision(9);
+		std::cerr << SimKernelGetIsaName(SimKernelGetIsa()) << " " << name << " row " << row << " " << field
+			<< ": got " << got[row] << " expected " << expected[row] << "\n";
+	}
+}
+
+/******************************************************************************/
+/*!
+	Runs rows begin to end - 1 of store on the current instruction set and on
+	the scalar one, every row of both has to match, the ones outside the
+	range included
+*/
+/******************************************************************************/
+static void TestCheck(const char* name, const EntityStore& store, unsigned int begin, unsigned int end, f32 dt)
+{
+	SIM_KERNEL_ISA isa = SimKernelGetIsa();
+
+	EntityStore expected = store;
+	SimKernelInit(SIM_KERNEL_SCALAR);
+	SimKernelIntegrateWrap(expected, begin, end, dt, TEST_HALF_EXTENT, TEST_BOUNDS);
+	SimKernelInit(isa);
+
+	EntityStore got = store;
+	SimKernelIntegrateWrap(got, begin, end, dt, TEST_HALF_EXTENT, TEST_BOUNDS);
+
+	for (unsigned int row = 0; row < store.capacity; row++)
+	{
+		TestCompare(name, "posX", row, got.posX, expected.posX);
+		TestCompare(name, "posY", row, got.posY, expected.posY);
+		TestCompare(name, "minX", row, got.minX, expected.minX);
+		TestCompare(name, "minY", row, got.minY, expected.minY);
+		TestCompare(name, "maxX", row, got.maxX, expected.maxX);
+		TestCompare(name, "maxY", row, got.maxY, expected.maxY);
+	}
+}
+
+/******************************************************************************/
+/*!
+	Rows that end the tick exactly on a wrap bound, one float inside it and
+	one float past it, on both axes and both sides, for every kind of margin.
+	the rows that stand still end exactly there, the moving ones within a
+	rounding of it
+*/
+/******************************************************************************/
+static void TestBounds()
+{
+	const f32 margins[] = { 0.0f, 10.0f, 60.0f, std::numeric_limits<f32>::infinity() };
+	const f32 inf = std::numeric_limits<f32>::infinity();
+	const f32 dt = 0.5f;
+
+	EntityStore store;
+	unsigned int row = 0;
+	auto add = [&](f32 x, f32 y, f32 vx, f32 vy, f32 margin) {
+		unsigned int r = row++;
+		store.posX[r] = x - vx * dt;
+		store.posY[r] = y - vy * dt;
+		store.velX[r] = vx;
+		store.velY[r] = vy;
+		store.scale[r] = 2.0f;
+		store.wrapMargin[r] = margin;
+	};
+
+	for (f32 margin : margins)
+	{
+		EntityStoreInit(store, 6 * 6 * 3);
+		row = 0;
+
+		f32 x0 = TEST_BOUNDS.minX - margin, x1 = TEST_BOUNDS.maxX + margin;
+		f32 y0 = TEST_BOUNDS.minY - margin, y1 = TEST_BOUNDS.maxY + margin;
+		if (margin == inf) {
+			x0 = TEST_BOUNDS.minX; x1 = TEST_BOUNDS.maxX;
+			y0 = TEST_BOUNDS.minY; y1 = TEST_BOUNDS.maxY;
+		}
+
+		const f32 xs[] = { x0, std::nextafter(x0, -inf), std::nextafter(x0, inf),
+			x1, std::nextafter(x1, inf), std::nextafter(x1, -inf) };
+		const f32 ys[] = { y0, std::nextafter(y0, -inf), std::nextafter(y0, inf),
+			y1, std::nextafter(y1, inf), std::nextafter(y1, -inf) };
+		for (f32 x : xs)
+		{
+			for (f32 y : ys)
+			{
+				add(x, y, 0.0f, 0.0f, margin);
+				add(x, y, 4.0f, -6.0f, margin);
+				add(x, y, -4.0f, 6.0f, margin);
+			}
+		}
+
+		TestCheck("bounds", store, 0, row, dt);
+	}
+}
+
+/******************************************************************************/
+/*!
+	Random rows, run over every start and end so each path gets every number
+	of tail rows and every misalignment
+*/
+/******************************************************************************/
+static void TestRandom()
+{
+	std::mt19937 random(1130);
+	std::uniform_real_distribution<f32> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<f32> velocity(-600.0f, 600.0f);
+	std::uniform_real_distribution<f32> scale(0.1f, 60.0f);
+	const f32 margins[] = { 0.0f, 10.0f, 60.0f, std::numeric_limits<f32>::infinity() };
+
+	EntityStore store;
+	EntityStoreInit(store, TEST_ROWS);
+	for (unsigned int pass = 0; pass < 16; pass++)
+	{
+		for (unsigned int r = 0; r < TEST_ROWS; r++)
+		{
+			store.posX[r] = position(random);
+			store.posY[r] = position(random);
+			store.velX[r] = velocity(random);
+			store.velY[r] = velocity(random);
+			store.scale[r] = scale(random);
+			store.wrapMargin[r] = margins[random() % 4];
+		}
+
+		for (unsigned int begin = 0; begin < 9; begin++)
+		{
+			for (unsigned int end = begin; end <= begin + 25; end++)
+				TestCheck("random", store, begin, end, 1.0f / 60.0f);
+		}
+	}
+}
+
+int main()
+{
+	const SIM_KERNEL_ISA isas[] = { SIM_KERNEL_SSE2, SIM_KERNEL_AVX2 };
+	for (SIM_KERNEL_ISA isa : isas)
+	{
+		SimKernelInit(isa);
+		if (SimKernelGetIsa() != isa) {
+			std::cout << SimKernelGetIsaName(isa) << ": not supported here, skipped\n";
+			continue;
+		}
+
+		unsigned int failures = sFailures;
+		TestBounds();
+		TestRandom();
+		std::cout << SimKernelGetIsaName(isa) << ": " << (sFailures == failures ? "ok" : "FAILED") << "\n";
+	}
+
+	return sFailures == 0 ? 0 : 1;
+}